@@ -0,0 +1,145 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2021
+ *
+ * Clock event devices
+ */
+
+#include <spede/stdio.h>
+
+#include "clockevent.h"
+#include "interrupts.h"
+#include "kernel.h"
+#include "kisr.h"
+#include "kutil.h"
+#include "lapic.h"
+#include "smp.h"
+#include "timer.h"
+
+// Clock event devices, most capable first
+static clockevent_t *clockevents[] = {
+    &lapic_tsc_deadline_clockevent,
+    &lapic_timer_clockevent,
+    &pit_clockevent
+};
+
+#define CLOCKEVENT_COUNT (sizeof(clockevents) / sizeof(clockevents[0]))
+
+// Clock event device used for the tick
+clockevent_t *clockevent;
+
+/**
+ * Selects the most capable clock event device and starts the tick on the
+ * bootstrap processor
+ */
+void clockevent_init() {
+    int i;
+
+    clockevent = NULL;
+
+    for (i = 0; i < CLOCKEVENT_COUNT; i++) {
+        if (clockevents[i]->probe() == 0) {
+            clockevent = clockevents[i];
+            break;
+        }
+    }
+
+    if (!clockevent) {
+        panic("No clock event device available");
+    }
+
+    printf("Initializing Timer (%s, %d Hz)\n", clockevent->name, TIMER_HZ);
+
+    // Keep the PIT from delivering ticks when it is not the tick device
+    if (clockevent != &pit_clockevent && irq_enabled(TIMER_INTR)) {
+        irq_disable(TIMER_INTR);
+    }
+
+    if (irq_register(clockevent->vector, kisr_timer, NULL) != 0) {
+        panic("Unable to register the timer interrupt handler");
+    }
+
+    cpu_this()->nohz_ticks = 0;
+    clockevent->set_periodic();
+}
+
+/**
+ * Starts the tick on an application processor
+ */
+void clockevent_cpu_init() {
+    if (!clockevent->percpu) {
+        panic("Clock event device %s cannot tick on CPU %d", clockevent->name, cpu_this()->id);
+    }
+
+    cpu_this()->nohz_ticks = 0;
+    clockevent->set_periodic();
+}
+
+/**
+ * Stops the periodic tick on the executing CPU and programs a single
+ * interrupt to occur after the specified number of ticks (limited to what
+ * the device can count)
+ * @param ticks - number of ticks until the next interrupt is needed
+ */
+void clockevent_nohz_enter(int ticks) {
+    cpu_t *cpu = cpu_this();
+
+    if (!TIMER_NOHZ || cpu->nohz_ticks) {
+        return;
+    }
+
+    if (ticks > clockevent->max_us / TIMER_TICK_US) {
+        ticks = clockevent->max_us / TIMER_TICK_US;
+    }
+
+    // Nothing is saved unless at least one tick can be skipped
+    if (ticks <= 1) {
+        return;
+    }
+
+    cpu->nohz_ticks = ticks;
+    clockevent->set_oneshot(ticks * TIMER_TICK_US);
+}
+
+/**
+ * Restores the periodic tick on the executing CPU after it was stopped
+ * @param expired - non-zero if the programmed interrupt occurred
+ * @return number of whole ticks that passed while the tick was stopped,
+ *         not counting the tick delivered by an expired timer interrupt
+ */
+int clockevent_nohz_exit(int expired) {
+    cpu_t *cpu = cpu_this();
+    int remaining;
+    int elapsed;
+
+    if (!cpu->nohz_ticks) {
+        return 0;
+    }
+
+    remaining = expired ? -1 : clockevent->remaining();
+
+    if (remaining < 0) {
+        // The timer interrupt was (or is about to be) delivered and
+        // accounts for the final tick
+        elapsed = cpu->nohz_ticks - 1;
+    } else {
+        // Woken early by another interrupt; work out how far the count got
+        elapsed = (cpu->nohz_ticks * TIMER_TICK_US - remaining) / TIMER_TICK_US;
+    }
+
+    cpu->nohz_ticks = 0;
+
+    // Restart the periodic tick from this point in time
+    clockevent->set_periodic();
+
+    return elapsed;
+}
+
+/**
+ * Queries if the periodic tick is currently stopped on the executing CPU
+ * @return 1 if stopped, 0 otherwise
+ */
+int clockevent_nohz_active() {
+    return cpu_this()->nohz_ticks != 0;
+}
@@ -0,0 +1,62 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2021
+ *
+ * Clock event devices
+ */
+#ifndef CLOCKEVENT_H
+#define CLOCKEVENT_H
+
+// Timer device that generates the tick
+typedef struct clockevent_t {
+    char *name;                     // Device name
+    int vector;                     // Interrupt vector the device raises
+    int percpu;                     // Each CPU has its own device
+    int max_us;                     // Longest one-shot delay (microseconds)
+
+    int (*probe)();                 // Detects the device (0 if usable)
+    void (*set_periodic)();         // Interrupts every tick
+    void (*set_oneshot)(int us);    // Interrupts once after a delay
+    int (*remaining)();             // Microseconds until the one-shot
+                                    // interrupt (-1 if it already expired)
+    void (*ack)();                  // Acknowledges a device interrupt
+} clockevent_t;
+
+// Clock event device used for the tick
+extern clockevent_t *clockevent;
+
+/**
+ * Selects the most capable clock event device and starts the tick on the
+ * bootstrap processor
+ */
+void clockevent_init();
+
+/**
+ * Starts the tick on an application processor
+ */
+void clockevent_cpu_init();
+
+/**
+ * Stops the periodic tick on the executing CPU and programs a single
+ * interrupt to occur after the specified number of ticks (limited to what
+ * the device can count)
+ * @param ticks - number of ticks until the next interrupt is needed
+ */
+void clockevent_nohz_enter(int ticks);
+
+/**
+ * Restores the periodic tick on the executing CPU after it was stopped
+ * @param expired - non-zero if the programmed interrupt occurred
+ * @return number of whole ticks that passed while the tick was stopped,
+ *         not counting the tick delivered by an expired timer interrupt
+ */
+int clockevent_nohz_exit(int expired);
+
+/**
+ * Queries if the periodic tick is currently stopped on the executing CPU
+ * @return 1 if stopped, 0 otherwise
+ */
+int clockevent_nohz_active();
+
+#endif
@@ -0,0 +1,206 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2021
+ *
+ * x87/SSE register state handling
+ */
+
+#include <spede/stdio.h>
+#include <spede/string.h>
+
+#include "fpu.h"
+#include "interrupts.h"
+#include "kernel.h"
+#include "kproc.h"
+#include "kutil.h"
+#include "smp.h"
+#include "x86.h"
+
+// Default SSE control/status register (all exceptions masked)
+#define FPU_MXCSR_DEFAULT 0x1f80
+
+// FXSAVE/FXRSTOR are supported (otherwise only the x87 state is saved)
+int fpu_fxsr;
+
+// SSE is supported
+int fpu_sse;
+
+// Register state every process starts with
+unsigned char fpu_init_state[FPU_STATE_SIZE] __attribute__((aligned(16)));
+
+/**
+ * Saves the FPU registers
+ * @param state - where to save the registers
+ */
+static void fpu_save(unsigned char *state) {
+    if (fpu_fxsr) {
+        asm volatile("fxsave (%0)" : : "r"(state) : "memory");
+    } else {
+        asm volatile("fnsave (%0)" : : "r"(state) : "memory");
+    }
+}
+
+/**
+ * Restores the FPU registers
+ * @param state - saved registers
+ */
+static void fpu_restore(unsigned char *state) {
+    if (fpu_fxsr) {
+        asm volatile("fxrstor (%0)" : : "r"(state) : "memory");
+    } else {
+        asm volatile("frstor (%0)" : : "r"(state) : "memory");
+    }
+}
+
+/**
+ * Gives a process the FPU on the executing CPU, saving the state of the
+ * process that last used it
+ * @param cpu - executing CPU
+ * @param proc - process entry
+ */
+static void fpu_load(cpu_t *cpu, proc_t *proc) {
+    asm volatile("clts");
+    cpu->fpu_live = 1;
+
+    if (cpu->fpu_owner == proc) {
+        return;
+    }
+
+    if (cpu->fpu_owner) {
+        fpu_save(cpu->fpu_owner->fpu_state);
+    }
+
+    fpu_restore(proc->fpu_state);
+    cpu->fpu_owner = proc;
+}
+
+/**
+ * Device not available handler
+ * Raised when the current process uses the FPU while CR0.TS is set
+ */
+static void fpu_trap(int irq, void *data) {
+    if (!current) {
+        panic("FPU used without a current process!");
+    }
+
+    fpu_load(cpu_this(), current);
+}
+
+/**
+ * Enables the FPU and, if supported, SSE on the bootstrap processor and
+ * registers the device not available handler
+ */
+void fpu_init() {
+    unsigned int a, b, c, d;
+
+    cpuid(CPUID_FEATURES, a, b, c, d);
+
+    fpu_fxsr = (d & CPUID_EDX_FXSR) ? 1 : 0;
+    fpu_sse = fpu_fxsr && (d & CPUID_EDX_SSE);
+
+    fpu_cpu_init();
+
+    // Capture the state of freshly initialized registers
+    asm volatile("clts");
+    asm volatile("fninit");
+
+    if (fpu_sse) {
+        a = FPU_MXCSR_DEFAULT;
+        asm volatile("ldmxcsr %0" : : "m"(a));
+    }
+
+    fpu_save(fpu_init_state);
+    cr_write(cr0, cr_read(cr0) | CR0_TS);
+
+    irq_register(FPU_INTR, fpu_trap, NULL);
+
+    printf("FPU state switching enabled (%s)\n", fpu_sse ? "SSE" : "x87");
+}
+
+/**
+ * Enables the FPU and SSE on the executing CPU
+ * The FPU starts unowned so the first process to use it traps.
+ */
+void fpu_cpu_init() {
+    cpu_t *cpu = cpu_this();
+
+    cr_write(cr0, (cr_read(cr0) & ~CR0_EM) | CR0_MP | CR0_NE | CR0_TS);
+
+    if (fpu_sse) {
+        cr_write(cr4, cr_read(cr4) | CR4_OSFXSR | CR4_OSXMMEXCPT);
+    }
+
+    cpu->fpu_owner = NULL;
+    cpu->fpu_last = NULL;
+    cpu->fpu_live = 0;
+}
+
+/**
+ * Gives a new process the initial FPU state
+ * @param proc - process entry
+ */
+void fpu_proc_init(proc_t *proc) {
+    memcpy(proc->fpu_state, fpu_init_state, FPU_STATE_SIZE);
+    proc->fpu_count = 0;
+}
+
+/**
+ * Releases the FPU registers held by a process that is exiting
+ * @param proc - process entry
+ */
+void fpu_proc_exit(proc_t *proc) {
+    int i;
+
+    // The registers are simply abandoned; the next process to use them
+    // restores its own state over them
+    for (i = 0; i < cpu_count; i++) {
+        if (cpus[i].fpu_owner == proc) {
+            cpus[i].fpu_owner = NULL;
+        }
+
+        if (cpus[i].fpu_last == proc) {
+            cpus[i].fpu_last = NULL;
+        }
+    }
+}
+
+/**
+ * Prepares the FPU for the process about to run on the executing CPU
+ * @param proc - process to run
+ */
+void fpu_switch(proc_t *proc) {
+    cpu_t *cpu = cpu_this();
+    proc_t *prev = cpu->fpu_last;
+
+    // The same process continues; leave the FPU as it is
+    if (proc == prev) {
+        return;
+    }
+
+    cpu->fpu_last = proc;
+
+    if (prev) {
+        if (cpu->fpu_live && cpu->fpu_owner == prev) {
+            prev->fpu_count++;
+
+            // Another CPU may resume the process, so its state can only
+            // stay in the registers when running on a single CPU
+            if (cpu_count > 1) {
+                fpu_save(prev->fpu_state);
+                cpu->fpu_owner = NULL;
+            }
+        } else {
+            prev->fpu_count = 0;
+        }
+    }
+
+    // Processes that keep using the FPU get their state right away rather
+    // than taking a trap every time slice
+    if (proc->fpu_count >= FPU_EAGER_SWITCHES) {
+        fpu_load(cpu, proc);
+    } else if (cpu->fpu_live) {
+        cr_write(cr0, cr_read(cr0) | CR0_TS);
+        cpu->fpu_live = 0;
+    }
+}
@@ -0,0 +1,60 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2021
+ *
+ * x87/SSE register state handling
+ */
+#ifndef FPU_H
+#define FPU_H
+
+// Size of the saved x87/SSE register state (FXSAVE format)
+#define FPU_STATE_SIZE 512
+
+// Number of consecutive time slices a process must use the FPU in before
+// its state is restored as soon as it is switched in (instead of on first
+// use); the count wraps after 255 so the process is checked again
+#define FPU_EAGER_SWITCHES 5
+
+#ifndef ASSEMBLER
+
+struct proc_t;
+
+/**
+ * Enables the FPU and, if supported, SSE on the bootstrap processor and
+ * registers the device not available handler
+ */
+void fpu_init();
+
+/**
+ * Enables the FPU and SSE on the executing CPU
+ * The FPU starts unowned so the first process to use it traps.
+ */
+void fpu_cpu_init();
+
+/**
+ * Gives a new process the initial FPU state
+ * @param proc - process entry
+ */
+void fpu_proc_init(struct proc_t *proc);
+
+/**
+ * Releases the FPU registers held by a process that is exiting
+ * @param proc - process entry
+ */
+void fpu_proc_exit(struct proc_t *proc);
+
+/**
+ * Prepares the FPU for the process about to run on the executing CPU
+ * Must be called before leaving the kernel.
+ *
+ * The registers are left holding the state of the last process to use
+ * them. Other processes run with CR0.TS set so their first FPU instruction
+ * traps and the state is switched then; processes that never use the FPU
+ * never pay for saving or restoring it.
+ * @param proc - process to run
+ */
+void fpu_switch(struct proc_t *proc);
+
+#endif
+#endif
@@ -7,13 +7,19 @@
  */
 
 #include <spede/stdio.h>
+#include <spede/string.h>
 #include <spede/machine/io.h>
 #include <spede/machine/proc_reg.h>
 #include <spede/machine/seg.h>
 
+#include "kernel.h"
 #include "kisr.h"
 #include "kutil.h"
 #include "interrupts.h"
+#include "x86.h"
+
+// Kernel stacks (one per CPU), defined in kisr_entry.S
+extern char kstack[];
 
 #define PIC1_BASE   0x20            // base address for PIC primary controller
 #define PIC2_BASE   0xa0            // base address for PIC secondary controller
@@ -27,6 +33,23 @@
 // Interrupt descriptor table
 struct i386_gate *idt_p;
 
+// Registered interrupt handler
+typedef struct irq_action_t {
+    irq_func_t func;                // Handler function
+    void *data;                     // Data passed to the handler
+    struct irq_action_t *next;      // Next handler for the same interrupt
+} irq_action_t;
+
+// Handlers registered for each interrupt
+irq_action_t *irq_actions[IRQ_VECTORS];
+
+// Pool of handler entries and list of the unused entries
+irq_action_t irq_action_pool[IRQ_HANDLER_MAX];
+irq_action_t *irq_action_free;
+
+// Number of times each interrupt has occurred
+unsigned int irq_counts[IRQ_VECTORS];
+
 
 // Forward Declarations
 void idt_entry_add(int entry_num, void (*func_ptr)());
@@ -37,18 +60,64 @@ void idt_entry_add(int entry_num, void (*func_ptr)());
  * This adds entries to the IDT and enables any IRQs in the PIC
  */
 void interrupts_init() {
+    int i;
+
     printf("Initializing Interrupts\n");
 
     // Get the IDT base address
     idt_p = get_idt_base();
 
+    // Start without any handlers registered
+    memset(irq_actions, 0, sizeof(irq_actions));
+    memset(irq_counts, 0, sizeof(irq_counts));
+
+    irq_action_free = NULL;
+
+    for (i = IRQ_HANDLER_MAX - 1; i >= 0; i--) {
+        irq_action_pool[i].next = irq_action_free;
+        irq_action_free = &irq_action_pool[i];
+    }
+
     // Add an entry for each interrupt into the IDT
-    idt_entry_add(TIMER_INTR, kisr_entry_timer);
+    for (i = 0; i < IRQ_PIC_LINES; i++) {
+        idt_entry_add(IRQ_PIC_BASE + i, kisr_entry_irq[i]);
+    }
+
+    idt_entry_add(FPU_INTR, kisr_entry_fpu);
 
     idt_entry_add(SYSCALL_INTR, kisr_entry_syscall);
 
-    // Enable IRQs in the PIC
-    irq_enable(TIMER_INTR);
+    idt_entry_add(LAPIC_TIMER_INTR, kisr_entry_lapic_timer);
+
+    idt_entry_add(LAPIC_SPURIOUS_INTR, kisr_entry_spurious);
+
+    irq_register(SYSCALL_INTR, kisr_syscall, NULL);
+
+    // IRQs are enabled in the PIC by the drivers that use them
+}
+
+/**
+ * Enables the fast system call entry (SYSENTER) on the executing CPU, if
+ * the CPU supports it
+ * @param cpu - index of the executing CPU
+ * @return 0 if enabled, -1 if not supported
+ */
+int sysenter_init(int cpu) {
+    unsigned int a, b, c, d;
+
+    cpuid(CPUID_FEATURES, a, b, c, d);
+
+    if (!(d & CPUID_EDX_SEP)) {
+        return -1;
+    }
+
+    // The entry switches to the caller's stack right away, but the stack
+    // pointer must still be valid (and distinct per CPU) when entered
+    msr_write(MSR_SYSENTER_CS, get_cs());
+    msr_write(MSR_SYSENTER_ESP, (unsigned int)&kstack[(cpu + 1) * KSTACK_SIZE]);
+    msr_write(MSR_SYSENTER_EIP, (unsigned int)kisr_entry_sysenter);
+
+    return 0;
 }
 
 /**
@@ -56,20 +125,111 @@ void interrupts_init() {
  * @param irq - interrupt number
  */
 void irq_handler(int irq) {
-    switch(irq) {
-        case TIMER_INTR:
-            kisr_timer();
-            break;
+    irq_action_t *action;
+    int pic_line;
 
-        case SYSCALL_INTR:
-            kisr_syscall();
-            break;
+    if (irq < 0 || irq >= IRQ_VECTORS) {
+        panic("Invalid interrupt: %d\n", irq);
+    }
+
+    irq_counts[irq]++;
+
+    pic_line = irq >= IRQ_PIC_BASE && irq < IRQ_PIC_BASE + IRQ_PIC_LINES;
+
+    // Stray interrupts from PIC lines without a driver are counted and
+    // dismissed; any other unexpected interrupt is a kernel bug
+    if (!irq_actions[irq] && !pic_line) {
+        panic("Unhandled interrupt: %d\n", irq);
+    }
+
+    for (action = irq_actions[irq]; action; action = action->next) {
+        action->func(irq, action->data);
+    }
 
-        default:
-            panic("Unhandled interrupt: %d\n", irq);
+    if (pic_line) {
+        irq_dismiss(irq);
     }
 }
 
+/**
+ * Registers a handler for an interrupt
+ * Several handlers may share an interrupt; each is run in the order it was
+ * registered. PIC interrupt lines are dismissed once all handlers have run.
+ * @param irq - interrupt number
+ * @param func - handler function
+ * @param data - data passed to the handler
+ * @return 0 on success, -1 on error
+ */
+int irq_register(int irq, irq_func_t func, void *data) {
+    irq_action_t *action;
+    irq_action_t **tail;
+
+    if (irq < 0 || irq >= IRQ_VECTORS || func == NULL) {
+        panic_warn("Invalid interrupt handler for interrupt %d", irq);
+        return -1;
+    }
+
+    if (!irq_action_free) {
+        panic_warn("No interrupt handlers available for interrupt %d", irq);
+        return -1;
+    }
+
+    action = irq_action_free;
+    irq_action_free = action->next;
+
+    action->func = func;
+    action->data = data;
+    action->next = NULL;
+
+    // Append the handler so handlers run in the order they were registered
+    for (tail = &irq_actions[irq]; *tail; tail = &(*tail)->next);
+    *tail = action;
+
+    return 0;
+}
+
+/**
+ * Removes a handler registered for an interrupt
+ * @param irq - interrupt number
+ * @param func - handler function
+ * @param data - data the handler was registered with
+ * @return 0 on success, -1 if the handler was not registered
+ */
+int irq_unregister(int irq, irq_func_t func, void *data) {
+    irq_action_t *action;
+    irq_action_t **prev;
+
+    if (irq < 0 || irq >= IRQ_VECTORS) {
+        return -1;
+    }
+
+    for (prev = &irq_actions[irq]; (action = *prev); prev = &action->next) {
+        if (action->func == func && action->data == data) {
+            *prev = action->next;
+
+            action->next = irq_action_free;
+            irq_action_free = action;
+
+            return 0;
+        }
+    }
+
+    return -1;
+}
+
+/**
+ * Returns the number of times an interrupt has occurred
+ * @param irq - interrupt number
+ * @return interrupt count
+ */
+unsigned int irq_count(int irq) {
+    if (irq < 0 || irq >= IRQ_VECTORS) {
+        return 0;
+    }
+
+    return irq_counts[irq];
+}
+
 /**
  * Adds an entry to the IDT
  * @param  entry_num - interrupt/entry number
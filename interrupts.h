@@ -8,11 +8,31 @@
 #ifndef INTERRUPTS_H
 #define INTERRUPTS_H
 
+// PIC interrupt lines (IRQ 0-15) are delivered on consecutive vectors
+#define IRQ_PIC_BASE 0x20
+#define IRQ_PIC_LINES 16
+
+// Number of interrupt vectors
+#define IRQ_VECTORS 256
+
+// Number of interrupt handlers that may be registered (across all vectors)
+#define IRQ_HANDLER_MAX 32
+
 // Interrupt definitions
+#define FPU_INTR 0x07       // Device not available (FPU used with CR0.TS set)
 #define TIMER_INTR 0x20     // IRQ 0 (Timer)
 #define SYSCALL_INTR 0x80   // System call Interrupt
+#define LAPIC_TIMER_INTR 0x40       // Local APIC timer
+#define LAPIC_SPURIOUS_INTR 0xff    // Local APIC spurious interrupt
 
 #ifndef ASSEMBLER
+/**
+ * Interrupt handler
+ * @param irq - interrupt number
+ * @param data - data given when the handler was registered
+ */
+typedef void (*irq_func_t)(int irq, void *data);
+
 /**
  * Configures and enables interrupts
  *   - Adds entries to the IDT
@@ -21,11 +41,47 @@
 void interrupts_init();
 
 /**
- * Handles the specified interrupt request
+ * Enables the fast system call entry (SYSENTER) on the executing CPU, if
+ * the CPU supports it
+ * @param cpu - index of the executing CPU
+ * @return 0 if enabled, -1 if not supported
+ */
+int sysenter_init(int cpu);
+
+/**
+ * Handles the specified interrupt request by running every handler
+ * registered for it
  * @param irq - interrupt number
  */
 void irq_handler(int irq);
 
+/**
+ * Registers a handler for an interrupt
+ * Several handlers may share an interrupt; each is run in the order it was
+ * registered. PIC interrupt lines are dismissed once all handlers have run.
+ * @param irq - interrupt number
+ * @param func - handler function
+ * @param data - data passed to the handler
+ * @return 0 on success, -1 on error
+ */
+int irq_register(int irq, irq_func_t func, void *data);
+
+/**
+ * Removes a handler registered for an interrupt
+ * @param irq - interrupt number
+ * @param func - handler function
+ * @param data - data the handler was registered with
+ * @return 0 on success, -1 if the handler was not registered
+ */
+int irq_unregister(int irq, irq_func_t func, void *data);
+
+/**
+ * Returns the number of times an interrupt has occurred
+ * @param irq - interrupt number
+ * @return interrupt count
+ */
+unsigned int irq_count(int irq);
+
 /**
  * Enables the specified irq
  * @param irq - interrupt number
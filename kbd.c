@@ -0,0 +1,234 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2021
+ *
+ * Keyboard driver
+ */
+
+#include <spede/stdio.h>
+#include <spede/machine/io.h>
+
+#include "interrupts.h"
+#include "kbd.h"
+#include "kernel.h"
+#include "kproc.h"
+#include "kutil.h"
+#include "scheduler.h"
+
+// Scan codes (set 1) that are not translated to keys
+#define KBD_SC_RELEASE      0x80    // Set when a key is released
+#define KBD_SC_EXTENDED     0xe0    // Prefix of extended keys
+#define KBD_SC_LSHIFT       0x2a
+#define KBD_SC_RSHIFT       0x36
+
+// Buffer of keys with a single producer and a single consumer
+// Each index only advances and is only written by one side, so keys can be
+// added while they are being taken out without any locking
+typedef struct kbd_ring_t {
+    char keys[KBD_BUF_SIZE];
+    volatile unsigned int head;     // Next key to add (producer only)
+    volatile unsigned int tail;     // Next key to take (consumer only)
+} kbd_ring_t;
+
+// Keys received by the interrupt handler, not yet dispatched
+static kbd_ring_t kbd_received;
+
+// Keys waiting for a process to read them
+static kbd_ring_t kbd_input;
+
+// Processes waiting for a key
+static proc_list_t kbd_wait_list;
+
+// Shift key held down
+static int kbd_shift;
+
+// Keys dropped because a buffer was full
+static unsigned int kbd_drop_count;
+
+// Command prefix typed; the next key is a kernel command
+static int kbd_cmd_next;
+
+// Keys for each scan code, without and with shift held
+static const char kbd_keys[][2] = {
+    [0x01] = { 0x1b, 0x1b },
+    [0x02] = { '1', '!' }, [0x03] = { '2', '@' }, [0x04] = { '3', '#' },
+    [0x05] = { '4', '$' }, [0x06] = { '5', '%' }, [0x07] = { '6', '^' },
+    [0x08] = { '7', '&' }, [0x09] = { '8', '*' }, [0x0a] = { '9', '(' },
+    [0x0b] = { '0', ')' }, [0x0c] = { '-', '_' }, [0x0d] = { '=', '+' },
+    [0x0e] = { '\b', '\b' }, [0x0f] = { '\t', '\t' },
+    [0x10] = { 'q', 'Q' }, [0x11] = { 'w', 'W' }, [0x12] = { 'e', 'E' },
+    [0x13] = { 'r', 'R' }, [0x14] = { 't', 'T' }, [0x15] = { 'y', 'Y' },
+    [0x16] = { 'u', 'U' }, [0x17] = { 'i', 'I' }, [0x18] = { 'o', 'O' },
+    [0x19] = { 'p', 'P' }, [0x1a] = { '[', '{' }, [0x1b] = { ']', '}' },
+    [0x1c] = { '\n', '\n' },
+    [0x1e] = { 'a', 'A' }, [0x1f] = { 's', 'S' }, [0x20] = { 'd', 'D' },
+    [0x21] = { 'f', 'F' }, [0x22] = { 'g', 'G' }, [0x23] = { 'h', 'H' },
+    [0x24] = { 'j', 'J' }, [0x25] = { 'k', 'K' }, [0x26] = { 'l', 'L' },
+    [0x27] = { ';', ':' }, [0x28] = { '\'', '"' }, [0x29] = { '`', '~' },
+    [0x2b] = { '\\', '|' },
+    [0x2c] = { 'z', 'Z' }, [0x2d] = { 'x', 'X' }, [0x2e] = { 'c', 'C' },
+    [0x2f] = { 'v', 'V' }, [0x30] = { 'b', 'B' }, [0x31] = { 'n', 'N' },
+    [0x32] = { 'm', 'M' }, [0x33] = { ',', '<' }, [0x34] = { '.', '>' },
+    [0x35] = { '/', '?' },
+    [0x39] = { ' ', ' ' }
+};
+
+/**
+ * Adds a key to a key buffer
+ * @return 0 on success, -1 if the buffer is full
+ */
+static int kbd_ring_put(kbd_ring_t *ring, char key) {
+    unsigned int head = ring->head;
+
+    if (head - ring->tail >= KBD_BUF_SIZE) {
+        kbd_drop_count++;
+        return -1;
+    }
+
+    ring->keys[head & (KBD_BUF_SIZE - 1)] = key;
+
+    // The key must be stored before the consumer can see it
+    asm volatile("" : : : "memory");
+    ring->head = head + 1;
+
+    return 0;
+}
+
+/**
+ * Takes the oldest key out of a key buffer
+ * @return 0 on success, -1 if the buffer is empty
+ */
+static int kbd_ring_get(kbd_ring_t *ring, char *key) {
+    unsigned int tail = ring->tail;
+
+    if (tail == ring->head) {
+        return -1;
+    }
+
+    *key = ring->keys[tail & (KBD_BUF_SIZE - 1)];
+
+    // The key must be read before the producer can reuse the slot
+    asm volatile("" : : : "memory");
+    ring->tail = tail + 1;
+
+    return 0;
+}
+
+/**
+ * Keyboard interrupt handler
+ * Translates the scan code and buffers the key; everything else is left
+ * to kbd_dispatch()
+ */
+static void kbd_isr(int irq, void *data) {
+    unsigned char code = inportb(KBD_DATA);
+
+    if (code == KBD_SC_EXTENDED) {
+        return;
+    }
+
+    if (code == KBD_SC_LSHIFT || code == KBD_SC_RSHIFT) {
+        kbd_shift = 1;
+        return;
+    }
+
+    if (code == (KBD_SC_LSHIFT | KBD_SC_RELEASE) || code == (KBD_SC_RSHIFT | KBD_SC_RELEASE)) {
+        kbd_shift = 0;
+        return;
+    }
+
+    if ((code & KBD_SC_RELEASE) || code >= sizeof(kbd_keys) / sizeof(kbd_keys[0])) {
+        return;
+    }
+
+    if (kbd_keys[code][0]) {
+        kbd_ring_put(&kbd_received, kbd_keys[code][kbd_shift]);
+    }
+}
+
+/**
+ * Initializes the keyboard and enables its interrupt
+ */
+void kbd_init() {
+    kbd_received.head = kbd_received.tail = 0;
+    kbd_input.head = kbd_input.tail = 0;
+    proc_list_init(&kbd_wait_list);
+    kbd_shift = 0;
+    kbd_drop_count = 0;
+    kbd_cmd_next = 0;
+
+    if (irq_register(IRQ_PIC_BASE + KBD_IRQ, kbd_isr, NULL) != 0) {
+        panic("Unable to register the keyboard interrupt handler");
+    }
+
+    // Discard any key pressed before the handler was registered
+    inportb(KBD_DATA);
+
+    irq_enable(KBD_IRQ);
+}
+
+/**
+ * Handles the keys received by the keyboard interrupt
+ */
+void kbd_dispatch() {
+    proc_t *proc;
+    char key;
+
+    while (kbd_ring_get(&kbd_received, &key) == 0) {
+        // A key after the command prefix is run as a kernel command even
+        // while a process waits for a key
+        if (kbd_cmd_next) {
+            kbd_cmd_next = 0;
+
+            if (kernel_command(key)) {
+                continue;
+            }
+        } else if (key == KBD_CMD_PREFIX) {
+            kbd_cmd_next = 1;
+            continue;
+        }
+
+        proc = proc_list_pop(&kbd_wait_list);
+
+        if (proc) {
+            *proc->key_dest = key;
+            proc->key_dest = NULL;
+            scheduler_add(proc);
+        } else if (!kernel_command(key)) {
+            kbd_ring_put(&kbd_input, key);
+        }
+    }
+}
+
+/**
+ * Reads a key for the current process
+ * @param key - where to store the key
+ * @return 0 on success, -1 on error
+ */
+int kbd_read(char *key) {
+    if (!key) {
+        return -1;
+    }
+
+    if (kbd_ring_get(&kbd_input, key) == 0) {
+        return 0;
+    }
+
+    // Wait for the next key to be typed
+    current->key_dest = key;
+    current->state = WAITING;
+    scheduler_remove(current);
+
+    if (proc_list_push(&kbd_wait_list, current) != 0) {
+        panic_warn("Unable to add process to the keyboard wait list");
+    }
+
+    return 0;
+}
+
+/**
+ * Returns the number of keys dropped because the buffers were full
+ */
+unsigned int kbd_dropped() {
+    return kbd_drop_count;
+}
@@ -0,0 +1,47 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2021
+ *
+ * Keyboard driver
+ */
+#ifndef KBD_H
+#define KBD_H
+
+#define KBD_IRQ         1       // Keyboard PIC interrupt line
+#define KBD_DATA        0x60    // Keyboard controller data port
+#define KBD_BUF_SIZE    64      // Keys buffered (must be a power of two)
+#define KBD_CMD_PREFIX  0x1b    // Escape; the next key is a kernel command
+
+/**
+ * Initializes the keyboard and enables its interrupt
+ */
+void kbd_init();
+
+/**
+ * Handles the keys received by the keyboard interrupt
+ * Each key is given to the process waiting longest for a key, if any. If
+ * no process is waiting, a key that is a kernel command (see
+ * kernel_command()) is run as one and any other key is kept for the next
+ * process to read a key.
+ * A key typed after KBD_CMD_PREFIX is always run as a kernel command, so
+ * the commands keep working while a process waits for input. Typing the
+ * prefix twice passes the prefix key itself on as input.
+ * Called from the kernel after the interrupt has been handled.
+ */
+void kbd_dispatch();
+
+/**
+ * Reads a key for the current process
+ * If no key is available, the current process waits until one is typed.
+ * @param key - where to store the key
+ * @return 0 on success, -1 on error
+ */
+int kbd_read(char *key);
+
+/**
+ * Returns the number of keys dropped because the buffers were full
+ */
+unsigned int kbd_dropped();
+
+#endif
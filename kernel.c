@@ -19,6 +19,15 @@
 #include "vga.h"
 #include "prog.h"
 #include "kmutex.h"
+#include "clockevent.h"
+#include "fpu.h"
+#include "kbd.h"
+#include "msgbuf.h"
+#include "timer.h"
+#include "tsc.h"
+#include "smp.h"
+#include "syscall.h"
+#include "uart.h"
 
 /**
  * Kernel data structures and variables
@@ -28,18 +37,12 @@
 // Current system time
 int system_time;
 
-// Next process id
-int next_pid;
-
-// Current process
-proc_t *current;
+// Process table entry generations
+int proc_gen[PROC_MAX];
 
 // Process queue
 queue_t proc_queue;
 
-// Run queue
-queue_t run_queue;
-
 // Process table
 proc_t proc_table[PROC_MAX];
 
@@ -49,6 +52,7 @@ char proc_stack[PROC_MAX][PROC_STACK_SIZE];
 
 int display_kernel_stats = 1;
 void kernel_stats();
+void kernel_stats_task();
 
 /**
  * Kernel Initialization
@@ -56,14 +60,19 @@ void kernel_stats();
  */
 void kernel_init() {
     int i;
+    proc_t *idle;
+
+    // Hold the kernel lock until the initial context switch so that other
+    // CPUs wait for the kernel to be initialized
+    kernel_lock_acquire();
 
     printf("Initializing kernel data structures\n");
 
     // Initialize system time
     system_time = 0;
 
-    // Initialize next process id
-    next_pid = 0;
+    // Initialize the process table entry generations
+    memset(proc_gen, 0, sizeof(proc_gen));
 
     // Initialize the process table
     memset(proc_table, 0, sizeof(proc_table));
@@ -90,14 +99,55 @@ void kernel_init() {
     // Initialize interrupts
     interrupts_init();
 
+    // Enable the fast system call entry
+    if (sysenter_init(0) == 0) {
+        printf("Fast system calls enabled\n");
+    }
+
+    // Measure the time stamp counter used for CPU time accounting
+    tsc_init();
+
+    // Switch the FPU registers between the processes that use them
+    fpu_init();
+
+    // Initialize the timer tick
+    clockevent_init();
+
     // Initialize the scheduler (and run queue)
     scheduler_init();
 
     // initialize mailbox
     mbox_init();
 
-    // Launch the idle task
-    kproc_exec(&kernel_idle, "idle task");
+    // Initialize the message buffer pool
+    msgbuf_init();
+
+    // Initialize the keyboard
+    kbd_init();
+
+    // Initialize the serial console
+    uart_init();
+
+    // Start the other CPUs
+    smp_init();
+
+    // Launch an idle task for each CPU
+    for (i = 0; i < cpu_count; i++) {
+        idle = kproc_lookup(kproc_exec(&kernel_idle, "idle task"));
+
+        if (!idle) {
+            panic("Unable to launch the idle task for CPU %d", i);
+        }
+
+        // The idle task only runs when nothing else is ready
+        scheduler_remove(idle);
+        idle->state = RUNNING;
+        idle->cpu = i;
+        cpus[i].idle = idle;
+    }
+
+    // Launch the kernel stats display task
+    kproc_exec(&kernel_stats_task, "stats task");
 
     // Launch the init task
     kproc_exec(&prog_init, "init task");
@@ -108,6 +158,8 @@ void kernel_init() {
 
     // Trigger the initial context switch
     printf("Performing initial context switch\n");
+    kernel_account_exit();
+    fpu_switch(current);
     kernel_context_switch(current->trapframe);
 }
 
@@ -118,64 +170,154 @@ void kernel_idle() {
     }
 }
 
+void kernel_stats_task() {
+    // Drawing the display should not hold up other processes
+    proc_set_priority(proc_get_pid(), PROC_PRIORITY_LOW);
+
+    while (1) {
+        if (display_kernel_stats) {
+            // Keep the kernel data consistent while it is displayed;
+            // interrupts would wait for the kernel lock on this CPU
+            asm("cli");
+            kernel_lock_acquire();
+            kernel_stats();
+            kernel_lock_release();
+            asm("sti");
+        }
+
+        msleep(KERNEL_STATS_PERIOD);
+    }
+}
+
+void kernel_account_enter() {
+    cpu_t *cpu = cpu_this();
+
+    cpu->tsc_enter = tsc_read();
+
+    if (current) {
+        current->cycles += cpu->tsc_enter - cpu->tsc_exit;
+    }
+}
+
+void kernel_account_exit() {
+    cpu_t *cpu = cpu_this();
+
+    cpu->tsc_exit = tsc_read();
+
+    if (cpu->tsc_enter) {
+        cpu->kernel_cycles += cpu->tsc_exit - cpu->tsc_enter;
+    }
+}
+
 void kernel_run(trapframe_t *trapframe) {
-    char kbd_ch;
+    int ticks;
+
+    // Charge the time since the last switch out of the kernel
+    kernel_account_enter();
 
     // Save the trapframe of the currently running process
     current->trapframe = trapframe;
 
+    // If the tick was stopped while idle, catch up on the time that passed
+    if (clockevent_nohz_active()) {
+        ticks = clockevent_nohz_exit(trapframe->interrupt == clockevent->vector);
+        system_time += ticks;
+        current->cpu_time += ticks;
+    }
+
     // Run the interrupt handler
     irq_handler(trapframe->interrupt);
 
-    if (cons_kbhit()) {
-        /* Read the character from the target keyboard buffer */
-        kbd_ch = cons_getchar();
+    // Handle the keys received by the keyboard interrupt
+    kbd_dispatch();
 
-        switch (kbd_ch) {
-            case 'b':
-                breakpoint();
-                break;
+    // Run the scheduler
+    scheduler_run();
 
-            case 'n':
-                kproc_exec(&prog_test, "test task");
-                break;
+    // If only the idle task can run, stop the tick until the next sleeping
+    // process needs to be woken up (or for up to a second if none are)
+    // Other CPUs may queue work for this one at any time, so the tick is
+    // only stopped when running on a single CPU
+    if (cpu_count == 1 && proc_is_idle(current)) {
+        ticks = scheduler_next_wake();
+        clockevent_nohz_enter(ticks < 0 ? TIMER_HZ : ticks - system_time);
+    }
+
+    // Perform the context switch out of the kernel
+    kernel_account_exit();
+    fpu_switch(current);
+    kernel_context_switch(current->trapframe);
+}
 
-            case 's':
-                display_kernel_stats = display_kernel_stats ? 0 : 1;
-                cons_clear();
-                break;
+int kernel_command(char key) {
+    switch (key) {
+        case 'b':
+            breakpoint();
+            break;
 
-            case 'x':
+        case 'n':
+            kproc_exec(&prog_test, "test task");
+            break;
+
+        case 's':
+            display_kernel_stats = display_kernel_stats ? 0 : 1;
+            cons_clear();
+            break;
+
+        case 'x':
+            if (current) {
                 kproc_exit(current);
-                break;
-
-            case 'q':
-                cons_printf("Exiting!!!");
-                exit(0);
-                break;
-
-            case 'p':
-                kproc_exec(&prog_producer, "Producer Program");
-                break;
-            
-            case 'c':
-                kproc_exec(&prog_consumer, "Consumer Program");
-                break;
-
-            default:
-                break;
-        }
+            }
+            break;
+
+        case 'q':
+            cons_printf("Exiting!!!");
+            exit(0);
+            break;
+
+        case 'p':
+            kproc_exec(&prog_producer, "Producer Program");
+            break;
+
+        case 'c':
+            kproc_exec(&prog_consumer, "Consumer Program");
+            break;
+
+        default:
+            return 0;
     }
 
-    // Display the kernel stats on the console
-    if (display_kernel_stats) {
-        kernel_stats();
+    return 1;
+}
+
+void kernel_sysenter(trapframe_t *trapframe) {
+    proc_t *proc = current;
+
+    // Catching up on a stopped tick is left to the full kernel path
+    if (clockevent_nohz_active()) {
+        kernel_run(trapframe);
     }
 
-    // Run the scheduler
+    kernel_account_enter();
+
+    // Save the trapframe of the calling process
+    proc->trapframe = trapframe;
+
+    // Run the system call
+    irq_handler(SYSCALL_INTR);
+
+    // Run the scheduler in case the process blocked or another process
+    // was woken up that should run first
     scheduler_run();
 
-    // Perform the context switch out of the kernel
+    kernel_account_exit();
+
+    // Return directly to the caller if it is still the process to run
+    if (current == proc) {
+        return;
+    }
+
+    fpu_switch(current);
     kernel_context_switch(current->trapframe);
 }
 
@@ -210,12 +352,12 @@ void kernel_stats() {
     memset(buf, 0, sizeof(buf));
     memset(buf, ' ', sizeof(buf)-1);
 
-    cons_clear();
+    vga_shadow_clear(vga_attr(VGA_COLOR_BLACK, VGA_COLOR_GREY, 0));
 
     row = 1;
 
-    vga_print_str(0, 0, header_attr, buf);
-    vga_print_str(0, 0, header_attr, "Entry    PID   State    Time   Command");
+    vga_shadow_str(0, 0, header_attr, buf);
+    vga_shadow_str(0, 0, header_attr, "Entry   PID State  CPU ms Miss Command");
 
     for (i = 0; i < PROC_MAX; i++) {
         proc = &proc_table[i];
@@ -241,21 +383,40 @@ void kernel_stats() {
             display_attr = unknown_attr;
         }
 
-        snprintf(buf, 80, "%5d  %5d  %4c  %8d   %s",
-                 i, proc->pid, state, proc->cpu_time, proc->name);
-        vga_print_str(row++, 0, display_attr, buf);
+        // Keep the row (with up to 17 characters of the name) left of the
+        // divider at column 48
+        snprintf(buf, 49, "%5d %5d %5c %7u %4d %s",
+                 i, proc->pid, state, (unsigned int)tsc_to_ms(proc->cycles),
+                 proc->rt_misses, proc->name);
+        vga_shadow_str(row++, 0, display_attr, buf);
     }
 
     snprintf(buf, 80, "%d", system_time);
-    vga_print_str(0, VGA_COL_MAX-8, header_attr, "Sys Time");
-    vga_print_str(1, VGA_COL_MAX-strlen(buf), default_attr, buf);
+    vga_shadow_str(0, VGA_COL_MAX-8, header_attr, "Sys Time");
+    vga_shadow_str(1, VGA_COL_MAX-strlen(buf), default_attr, buf);
+
+    snprintf(buf, 80, "%d", sched_rt_misses);
+    vga_shadow_str(3, VGA_COL_MAX-7, header_attr, "DL Miss");
+    vga_shadow_str(4, VGA_COL_MAX-strlen(buf), default_attr, buf);
+
+    snprintf(buf, 80, "%u", tsc_khz / 1000);
+    vga_shadow_str(6, VGA_COL_MAX-7, header_attr, "TSC MHz");
+    vga_shadow_str(7, VGA_COL_MAX-strlen(buf), default_attr, buf);
+
+    snprintf(buf, 80, "%u", kbd_dropped());
+    vga_shadow_str(9, VGA_COL_MAX-8, header_attr, "Kbd Drop");
+    vga_shadow_str(10, VGA_COL_MAX-strlen(buf), default_attr, buf);
+
+    snprintf(buf, 80, "%u", uart_dropped());
+    vga_shadow_str(12, VGA_COL_MAX-9, header_attr, "UART Drop");
+    vga_shadow_str(13, VGA_COL_MAX-strlen(buf), default_attr, buf);
 
     row = 1;
 
-    vga_print_char(0, 48, header_attr, 186);
-    vga_print_char(0, 70, header_attr, 186);
+    vga_shadow_char(0, 48, header_attr, 186);
+    vga_shadow_char(0, 70, header_attr, 186);
 
-    vga_print_str(0, 50, header_attr, "Mutex  Owner  Locks");
+    vga_shadow_str(0, 50, header_attr, "Mutex  Owner  Locks");
 
     for (i = 0; i < MUTEX_MAX; i++) {
         if (mutexes[i].allocated != 1) {
@@ -263,7 +424,9 @@ void kernel_stats() {
         }
 
         snprintf(buf, 80, "%5d  %5d  %5d", i, mutexes[i].owner ? mutexes[i].owner->pid : -1, mutexes[i].lock_count);
-        vga_print_str(row++, 50, default_attr, buf);
+        vga_shadow_str(row++, 50, default_attr, buf);
     }
-}
 
+    // Only the characters that changed are written to the screen
+    vga_shadow_flush();
+}
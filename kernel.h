@@ -24,6 +24,11 @@
 #include "kmutex.h"
 #include "kproc.h"
 #include "queue.h"
+#include "scheduler.h"
+#include "smp.h"
+
+// Kernel stats display refresh period (in milliseconds)
+#define KERNEL_STATS_PERIOD 250
 
 /**
  * Kernel data structures
@@ -32,11 +37,11 @@
 // System time
 extern int system_time;
 
-// Next available process id
-extern int next_pid;
+// Process table entry generations (used to build process ids)
+extern int proc_gen[PROC_MAX];
 
-// Current process
-extern proc_t *current;
+// Current process (of the executing CPU)
+#define current (cpu_this()->current)
 
 // Process table
 extern proc_t proc_table[PROC_MAX];
@@ -47,9 +52,6 @@ extern char proc_stack[PROC_MAX][PROC_STACK_SIZE];
 // Available process table entries
 extern queue_t proc_queue;
 
-// Running processes
-extern queue_t run_queue;
-
 // Mutex data structures
 extern mutex_t mutexes[MUTEX_MAX];
 extern queue_t mutex_queue;
@@ -73,6 +75,33 @@ void kernel_init();
  */
 void kernel_idle();
 
+/*
+ * Kernel CPU time accounting
+ * Charges the cycles since the executing CPU last left the kernel to the
+ * current process; called on every entry to the kernel
+ */
+void kernel_account_enter();
+
+/*
+ * Kernel CPU time accounting
+ * Records the time the executing CPU leaves the kernel; called before
+ * every switch out of the kernel
+ */
+void kernel_account_exit();
+
+/*
+ * Runs the kernel command for a key typed on the console
+ * Returns 1 if the key is a command, 0 if not
+ */
+int kernel_command(char key);
+
+/*
+ * Fast system call handler (entered through SYSENTER)
+ * Returns to the caller directly if it can keep running, otherwise
+ * switches to the next process like kernel_run()
+ */
+void kernel_sysenter(trapframe_t *trapframe);
+
 /**
  * Implementation in kernel_entry.S
  * Performs the context switch out of the kernel
@@ -8,18 +8,25 @@
 
 #include <spede/machine/io.h>
 
+#include "clockevent.h"
 #include "interrupts.h"
 #include "kernel.h"
 #include "kisr.h"
 #include "ksyscall.h"
 #include "kutil.h"
+#include "scheduler.h"
 
 /**
- * Kernel Interrupt Service Routine: Timer (IRQ 0)
+ * Kernel Interrupt Service Routine: Timer
+ * Tick from the clock event device of each CPU (registered by
+ * clockevent_init()); only the bootstrap processor's tick advances the
+ * system time
  */
-void kisr_timer() {
+void kisr_timer(int irq, void *data) {
     // Increment the system time
-    system_time++;
+    if (cpu_this()->id == 0) {
+        system_time++;
+    }
 
     // Increment the current process' active time
     current->active_time++;
@@ -27,7 +34,10 @@ void kisr_timer() {
     // Increment the current process' cpu time
     current->cpu_time++;
 
-    irq_dismiss(TIMER_INTR);
+    // Charge the tick to the current process' scheduling class
+    scheduler_tick(current);
+
+    clockevent->ack();
 }
 
 /**
@@ -36,7 +46,7 @@ void kisr_timer() {
  * parameters sent from the caller via the trapframe.
  * Return code/value to the caller set via the trapframe.
  */
-void kisr_syscall() {
+void kisr_syscall(int irq, void *data) {
     int rc;
 
     if (!current || !current->trapframe) {
@@ -17,18 +17,22 @@
  */
 
 // Timer ISR
-void kisr_timer();
+void kisr_timer(int irq, void *data);
 
 // System call ISR
-void kisr_syscall();
+void kisr_syscall(int irq, void *data);
 
 
 /* Defined in kisr_entry.S */
 __BEGIN_DECLS
 
 // Kernel interrupt entries
-extern void kisr_entry_timer();
+extern void (*kisr_entry_irq[IRQ_PIC_LINES])();     // PIC interrupt lines
+extern void kisr_entry_fpu();
 extern void kisr_entry_syscall();
+extern void kisr_entry_sysenter();
+extern void kisr_entry_lapic_timer();
+extern void kisr_entry_spurious();
 
 __END_DECLS
 #endif
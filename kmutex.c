@@ -151,9 +151,8 @@ int kmutex_lock(int id) {
  */
 int kmutex_unlock(int id) {
     mutex_t *mutex;
-    proc_t *proc;
+    proc_t *proc = NULL;
     int pid = -1;
-    int i = 0;
 
 
     if (id < 0 || id >= MUTEX_MAX) {
@@ -183,27 +182,28 @@ int kmutex_unlock(int id) {
     // Decrement the lock count
     mutex->lock_count--;
 
-    if (mutex->lock_count == 0) {
-        // No more owner as all locks have been released
-        mutex->owner = NULL;
-    } else {
+    // Obtain the next waiting process, skipping any that have exited
+    // (each of which still holds a count from when it started waiting)
+    while (mutex->lock_count > 0 && !proc) {
         if (queue_out(&mutex->wait_queue, &pid) != 0) {
             panic_warn("No processes in the mutex queue");
             return -1;
         }
 
-        for (i = 0; i < PROC_MAX; i++) {
-            proc = &proc_table[i];
-
-            if (proc->pid == pid) {
-                scheduler_add(proc);
-                mutex->owner = proc;
-                proc->state = RUNNING;
+        proc = kproc_lookup(pid);
 
-                break;
-            }
+        if (!proc) {
+            mutex->lock_count--;
         }
     }
 
+    if (proc) {
+        scheduler_add(proc);
+        mutex->owner = proc;
+    } else {
+        // No more owner as all locks have been released
+        mutex->owner = NULL;
+    }
+
     return mutex->lock_count;
 }
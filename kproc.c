@@ -10,10 +10,13 @@
 #include <spede/string.h>
 #include <spede/machine/proc_reg.h>
 
+#include "fpu.h"
 #include "kernel.h"
 #include "kutil.h"
 #include "kproc.h"
+#include "mbox.h"
 #include "scheduler.h"
+#include "uart.h"
 
 
 /**
@@ -48,16 +51,22 @@ int kproc_exec(void *proc_ptr, char *proc_name) {
     // Initialize the PCB entry for the process
     memset(proc, 0, sizeof(proc_t));
 
+    // Start with freshly initialized FPU registers
+    fpu_proc_init(proc);
+
     // Point the stack to the process stack
     proc->stack = proc_stack[proc_entry];
 
     // Set the process state to RUNNING
     // Initialize other process control block variables to default values
-    proc->pid         = next_pid++;
+    proc->pid         = PROC_PID(proc_entry, proc_gen[proc_entry]);
     proc->state       = RUNNING;
     proc->active_time = 0;
     proc->cpu_time    = 0;
     proc->start_time  = system_time;
+    proc->priority    = PROC_PRIORITY_HIGH;
+    proc->level       = PROC_PRIORITY_HIGH;
+    proc->cpu         = scheduler_select_cpu();
 
     // Copy the process name to the PCB
     strncpy(proc->name, proc_name, PROC_NAME_LEN);
@@ -84,7 +93,7 @@ int kproc_exec(void *proc_ptr, char *proc_name) {
     // Add the process to the run queue
     scheduler_add(proc);
 
-    printf("Executed process %s (%d) entry=%d\n", proc->name, proc->pid, proc_entry);
+    uart_printf("Executed process %s (%d) entry=%d\n", proc->name, proc->pid, proc_entry);
 
     return proc->pid;
 }
@@ -93,46 +102,199 @@ int kproc_exec(void *proc_ptr, char *proc_name) {
  * Exit the currently running process
  */
 void kproc_exit(proc_t *proc) {
-    int i;
+    int entry;
 
     if (proc == NULL) {
         panic("Invalid process!");
         return;
     }
 
-    if (proc->pid == 0) {
+    if (proc_is_idle(proc)) {
         printf("Cannot exit the idle task\n");
         return;
     }
 
+    // Release any real-time reservation held by the process
+    scheduler_set_rt(proc, 0, 0, 0);
+
     // Remove the process from the scheduler
     scheduler_remove(proc);
 
+    // Remove the process from any list it is waiting in
+    if (proc->list) {
+        proc_list_remove(proc);
+    }
+
+    // Stop waiting for messages on any mailboxes (see msg_select())
+    mbox_notify_cancel(proc);
+
     // Clean up the process table for the process
-    for (i = 0; i < PROC_MAX; i++) {
-        if (proc->pid == proc_table[i].pid) {
-            printf("Exiting process %s (%d) entry=%d\n", proc->name, proc->pid, i);
+    if (kproc_lookup(proc->pid) != proc) {
+        // If we got here, something bad happened
+        panic("Unable to exit process!");
+    }
+
+    entry = PROC_PID_ENTRY(proc->pid);
+
+    uart_printf("Exiting process %s (%d) entry=%d\n", proc->name, proc->pid, entry);
+
+    // Send anything the process wrote without finishing the line
+    uart_proc_flush(proc);
 
-            // Clear out the process stack
-            memset(proc->stack, 0, PROC_STACK_SIZE);
+    // Release the message buffers the process holds
+    msgbuf_proc_exit(proc);
+
+    // Release the FPU registers if the process holds them
+    fpu_proc_exit(proc);
+
+    // Clear out the process stack
+    memset(proc->stack, 0, PROC_STACK_SIZE);
+
+    // Clear out the process control block data
+    memset(proc, 0, sizeof(proc_t));
+
+    // Advance the entry generation so the old pid can no longer be resolved
+    proc_gen[entry]++;
+
+    // Add the proc entry back to the proc queue
+    queue_in(&proc_queue, entry);
+
+    // if the current process is being exited, make sure we handle it
+    if (current == proc) {
+        current = NULL;
+    }
+}
 
-            // Clear out the process control block data
-            memset(proc, 0, sizeof(proc_t));
+/**
+ * Looks up the process entry for the given process id
+ * @param pid - process id
+ * @return pointer to the process entry, NULL if the pid is invalid or stale
+ */
+proc_t *kproc_lookup(int pid) {
+    proc_t *proc;
 
-            // Add the proc entry back to the proc queue
-            queue_in(&proc_queue, i);
+    if (pid < 0) {
+        return NULL;
+    }
 
-            // if the current process is being exited, make sure we handle it
-            if (current == proc) {
-                current = NULL;
-            }
+    proc = &proc_table[PROC_PID_ENTRY(pid)];
 
-            // Return as there is nothing else to do
-            return;
-        }
+    // The entry must be in use and still belong to the same generation
+    if (proc->state == NONE || proc->pid != pid) {
+        return NULL;
     }
 
-    // If we got here, something bad happened
-    panic("Unable to exit process!");
+    return proc;
+}
+
+/**
+ * Initializes an empty process list
+ * @param list - pointer to the process list
+ */
+void proc_list_init(proc_list_t *list) {
+    list->head = NULL;
+    list->tail = NULL;
+    list->size = 0;
+}
+
+/**
+ * Adds a process to the tail of a process list
+ * @param list - pointer to the process list
+ * @param proc - process entry (must not already be in a list)
+ * @return 0 on success, -1 on error
+ */
+int proc_list_push(proc_list_t *list, proc_t *proc) {
+    return proc_list_insert(list, NULL, proc);
 }
 
+/**
+ * Inserts a process into a process list ahead of another process
+ * @param list - pointer to the process list
+ * @param next - process to insert ahead of (NULL to add to the tail)
+ * @param proc - process entry (must not already be in a list)
+ * @return 0 on success, -1 on error
+ */
+int proc_list_insert(proc_list_t *list, proc_t *next, proc_t *proc) {
+    if (!list || !proc || proc->list) {
+        return -1;
+    }
+
+    if (next && next->list != list) {
+        return -1;
+    }
+
+    proc->next = next;
+    proc->prev = next ? next->prev : list->tail;
+
+    if (proc->prev) {
+        proc->prev->next = proc;
+    } else {
+        list->head = proc;
+    }
+
+    if (next) {
+        next->prev = proc;
+    } else {
+        list->tail = proc;
+    }
+
+    list->size++;
+
+    proc->list = list;
+
+    return 0;
+}
+
+/**
+ * Removes the process at the head of a process list
+ * @param list - pointer to the process list
+ * @return pointer to the process entry, NULL if the list is empty
+ */
+proc_t *proc_list_pop(proc_list_t *list) {
+    proc_t *proc;
+
+    if (!list || !list->head) {
+        return NULL;
+    }
+
+    proc = list->head;
+    proc_list_remove(proc);
+
+    return proc;
+}
+
+/**
+ * Removes a process from the process list that holds it
+ * @param proc - process entry
+ * @return 0 on success, -1 if the process is not in a list
+ */
+int proc_list_remove(proc_t *proc) {
+    proc_list_t *list;
+
+    if (!proc || !proc->list) {
+        return -1;
+    }
+
+    list = proc->list;
+
+    // Unlink the process from its neighbors
+    if (proc->prev) {
+        proc->prev->next = proc->next;
+    } else {
+        list->head = proc->next;
+    }
+
+    if (proc->next) {
+        proc->next->prev = proc->prev;
+    } else {
+        list->tail = proc->prev;
+    }
+
+    list->size--;
+
+    proc->next = NULL;
+    proc->prev = NULL;
+    proc->list = NULL;
+
+    return 0;
+}
@@ -8,12 +8,22 @@
 #ifndef KPROC_H
 #define KPROC_H
 
+#include "fpu.h"
+#include "msgbuf.h"
+#include "timer.h"
 #include "trapframe.h"
 
 #define PROC_MAX        24   // maximum number of processes to support
 #define PROC_NAME_LEN   32   // Maximum length of a process name
 #define PROC_STACK_SIZE 8192 // Process stack size
-#define PROC_TIMESLICE  5    // Number of ticks a process can execute at a time
+#define PROC_TIMESLICE  TIMER_MS(50) // Default number of ticks a process can execute at a time
+#define PROC_WRITE_BUF_SIZE 128 // Characters a process' writes are buffered in
+
+// Process ids encode the process table entry along with a generation count
+// for that entry so that a pid can be resolved without searching and stale
+// pids (from exited processes) can be detected
+#define PROC_PID(entry, gen)    ((gen) * PROC_MAX + (entry))
+#define PROC_PID_ENTRY(pid)     ((pid) % PROC_MAX)
 
 // Process States
 typedef enum {
@@ -24,6 +34,13 @@ typedef enum {
     WAITING     // Process is waiting (unscheduled)
 } state_t;
 
+// Intrusive list of processes (linked through the process entries)
+typedef struct proc_list_t {
+    struct proc_t *head;      // First process in the list
+    struct proc_t *tail;      // Last process in the list
+    int size;                 // Number of processes in the list
+} proc_list_t;
+
 typedef struct proc_t {
     int pid;                  // Process id
     int state;                // Process state
@@ -32,12 +49,52 @@ typedef struct proc_t {
 
     int start_time;           // Time started
     int cpu_time;             // Total CPU time
+    unsigned long long cycles; // Total CPU time in time stamp counter cycles
     int active_time;          // Current active time
     int wake_time;            // Time when process should wake from sleeping
+    int sleep_pos;            // Position in the sleep queue (0 if not queued)
+
+    int priority;             // Base scheduling priority
+    int level;                // Current scheduling level (priority or lower)
+    int level_start;          // CPU time when the process entered its level
+    int cpu;                  // CPU whose run queues hold the process
+
+    int timeslice;            // Time slice in ticks (0 for PROC_TIMESLICE)
+    int timeslice_adaptive;   // Adapt the time slice to how the process runs
+
+    int tickets;              // Stride scheduling tickets (0 if not used)
+    int stride;               // Stride scheduling pass increment per tick
+    int pass;                 // Stride scheduling pass
+
+    int rt_period;            // Real-time period (0 if not real-time)
+    int rt_budget;            // Real-time CPU budget per period
+    int rt_rel_deadline;      // Real-time deadline relative to each release
+    int rt_util;              // CPU share reserved (per mille)
+    int rt_release;           // Time the next real-time job is released
+    int rt_deadline;          // Deadline of the current real-time job
+    int rt_remaining;         // Budget left for the current real-time job
+    int rt_misses;            // Number of real-time deadlines missed
+
+    struct msg_t *msg_dest;   // Where a blocked msg_recv receives into
+    int msg_size;             // Bytes of data msg_dest can hold
+    unsigned char msgbuf_refs[MSGBUF_MAX]; // References held to each message buffer
+    char *key_dest;           // Where a blocked sys_read_key stores the key
+
+    char write_buf[PROC_WRITE_BUF_SIZE]; // Characters written (see sys_write)
+    int write_len;            // Number of characters in the write buffer
+
+    unsigned char fpu_count;  // Consecutive time slices the FPU was used in
+
+    // Saved x87/SSE registers (FXSAVE requires 16 byte alignment)
+    unsigned char fpu_state[FPU_STATE_SIZE] __attribute__((aligned(16)));
 
     char *stack;              // Pointer to the stack
 
     trapframe_t *trapframe;   // Pointer to the trapframe
+
+    struct proc_t *next;      // Next process in the process list
+    struct proc_t *prev;      // Previous process in the process list
+    proc_list_t *list;        // Process list holding the process (if any)
 } proc_t;
 
 /**
@@ -58,4 +115,52 @@ int kproc_exec(void *proc_ptr, char *proc_name);
  */
 void kproc_exit(proc_t *proc);
 
+/**
+ * Looks up the process entry for the given process id
+ * @param pid - process id
+ * @return pointer to the process entry, NULL if the pid is invalid or stale
+ */
+proc_t *kproc_lookup(int pid);
+
+/**
+ * Process list functions
+ */
+
+/**
+ * Initializes an empty process list
+ * @param list - pointer to the process list
+ */
+void proc_list_init(proc_list_t *list);
+
+/**
+ * Adds a process to the tail of a process list
+ * @param list - pointer to the process list
+ * @param proc - process entry (must not already be in a list)
+ * @return 0 on success, -1 on error
+ */
+int proc_list_push(proc_list_t *list, proc_t *proc);
+
+/**
+ * Inserts a process into a process list ahead of another process
+ * @param list - pointer to the process list
+ * @param next - process to insert ahead of (NULL to add to the tail)
+ * @param proc - process entry (must not already be in a list)
+ * @return 0 on success, -1 on error
+ */
+int proc_list_insert(proc_list_t *list, proc_t *next, proc_t *proc);
+
+/**
+ * Removes the process at the head of a process list
+ * @param list - pointer to the process list
+ * @return pointer to the process entry, NULL if the list is empty
+ */
+proc_t *proc_list_pop(proc_list_t *list);
+
+/**
+ * Removes a process from the process list that holds it
+ * @param proc - process entry
+ * @return 0 on success, -1 if the process is not in a list
+ */
+int proc_list_remove(proc_t *proc);
+
 #endif
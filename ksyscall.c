@@ -9,6 +9,7 @@
 #include <spede/string.h>
 #include <spede/stdio.h>
 
+#include "kbd.h"
 #include "kernel.h"
 #include "kproc.h"
 #include "ksyscall.h"
@@ -17,6 +18,55 @@
 #include "queue.h"
 #include "scheduler.h"
 #include "mbox.h"
+#include "msgbuf.h"
+#include "timer.h"
+#include "tsc.h"
+#include "uart.h"
+
+/**
+ * System call dispatch table, indexed by system call number
+ * Handlers are called with the number of arguments recorded in the table
+ */
+ksyscall_t ksyscalls[SYSCALL_MAX] = {
+    [SYSCALL_SYS_GET_TIME]          = { "sys_get_time",          0, ksyscall_sys_get_time },
+    [SYSCALL_PROC_EXEC]             = { "proc_exec",             2, ksyscall_proc_exec },
+    [SYSCALL_PROC_EXIT]             = { "proc_exit",             0, ksyscall_proc_exit },
+    [SYSCALL_PROC_GET_NAME]         = { "proc_get_name",         1, ksyscall_proc_get_name },
+    [SYSCALL_PROC_GET_PID]          = { "proc_get_pid",          0, ksyscall_proc_get_pid },
+    [SYSCALL_SLEEP]                 = { "sleep",                 1, ksyscall_sleep },
+    [SYSCALL_YIELD]                 = { "yield",                 0, ksyscall_yield },
+    [SYSCALL_MUTEX_ALLOC]           = { "mutex_alloc",           0, ksyscall_mutex_alloc },
+    [SYSCALL_MUTEX_FREE]            = { "mutex_free",            1, ksyscall_mutex_free },
+    [SYSCALL_MUTEX_LOCK]            = { "mutex_lock",            1, ksyscall_mutex_lock },
+    [SYSCALL_MUTEX_UNLOCK]          = { "mutex_unlock",          1, ksyscall_mutex_unlock },
+    [SYSCALL_MSG_SEND]              = { "msg_send",              2, ksyscall_msg_send },
+    [SYSCALL_MSG_RECV]              = { "msg_recv",              2, ksyscall_msg_recv },
+    [SYSCALL_PROC_SET_PRIORITY]     = { "proc_set_priority",     2, ksyscall_proc_set_priority },
+    [SYSCALL_PROC_GET_PRIORITY]     = { "proc_get_priority",     1, ksyscall_proc_get_priority },
+    [SYSCALL_PROC_SET_TICKETS]      = { "proc_set_tickets",      2, ksyscall_proc_set_tickets },
+    [SYSCALL_PROC_SET_RT]           = { "proc_set_rt",           2, ksyscall_proc_set_rt },
+    [SYSCALL_PROC_SET_TIMESLICE]    = { "proc_set_timeslice",    3, ksyscall_proc_set_timeslice },
+    [SYSCALL_PROC_GET_USAGE]        = { "proc_get_usage",        2, ksyscall_proc_get_usage },
+    [SYSCALL_MSLEEP]                = { "msleep",                1, ksyscall_msleep },
+    [SYSCALL_USLEEP]                = { "usleep",                1, ksyscall_usleep },
+    [SYSCALL_SYS_GET_TIME_MS]       = { "sys_get_time_ms",       0, ksyscall_sys_get_time_ms },
+    [SYSCALL_SYS_GET_HZ]            = { "sys_get_hz",            0, ksyscall_sys_get_hz },
+    [SYSCALL_SYS_GET_SYSCALL_STATS] = { "sys_get_syscall_stats", 2, ksyscall_sys_get_syscall_stats },
+    [SYSCALL_BATCH]                 = { "batch",                 2, ksyscall_batch },
+    [SYSCALL_SYS_READ_KEY]          = { "sys_read_key",          1, ksyscall_sys_read_key },
+    [SYSCALL_SYS_WRITE]             = { "sys_write",             2, ksyscall_sys_write },
+    [SYSCALL_MSG_SEND_DONATE]       = { "msg_send_donate",       2, ksyscall_msg_send_donate },
+    [SYSCALL_MSG_SEND_SIZE]         = { "msg_send_size",         3, ksyscall_msg_send_size },
+    [SYSCALL_MSG_RECV_SIZE]         = { "msg_recv_size",         3, ksyscall_msg_recv_size },
+    [SYSCALL_MSG_SEND_BUF]          = { "msg_send_buf",          3, ksyscall_msg_send_buf },
+    [SYSCALL_MSG_BUF_ALLOC]         = { "msg_buf_alloc",         2, ksyscall_msg_buf_alloc },
+    [SYSCALL_MSG_BUF_MAP]           = { "msg_buf_map",           2, ksyscall_msg_buf_map },
+    [SYSCALL_MSG_BUF_DUP]           = { "msg_buf_dup",           1, ksyscall_msg_buf_dup },
+    [SYSCALL_MSG_BUF_RELEASE]       = { "msg_buf_release",       1, ksyscall_msg_buf_release },
+    [SYSCALL_MSG_TRY_RECV]          = { "msg_try_recv",          2, ksyscall_msg_try_recv },
+    [SYSCALL_MSG_RECV_TIMEOUT]      = { "msg_recv_timeout",      3, ksyscall_msg_recv_timeout },
+    [SYSCALL_MSG_SELECT]            = { "msg_select",            2, ksyscall_msg_select }
+};
 
 /**
  * System call handler
@@ -28,71 +78,153 @@
  * @return return value from the specified system call function
  */
 int ksyscall_handler(int syscall, unsigned int arg1, unsigned int arg2, unsigned int arg3) {
-    // Default return value
-    int rc = -1;
-
-    // Dispatch to the appropriate function
-    // Cast parameters as necessary
-    switch (syscall) {
-        case SYSCALL_SLEEP:
-            rc = ksyscall_sleep((int)arg1);
-            break;
+    ksyscall_t *entry;
+    unsigned long long start;
+    int rc;
 
-        case SYSCALL_YIELD:
-            rc = ksyscall_yield();
-            break;
+    if (syscall < 0 || syscall >= SYSCALL_MAX || !ksyscalls[syscall].func) {
+        panic_warn("Invalid system call %d!", syscall);
+        return -1;
+    }
 
-        case SYSCALL_PROC_EXEC:
-            rc = ksyscall_proc_exec((char *)arg1, (void *)arg2);
-            break;
+    entry = &ksyscalls[syscall];
 
-        case SYSCALL_PROC_EXIT:
-            rc = ksyscall_proc_exit();
-            break;
+    start = tsc_read();
 
-        case SYSCALL_SYS_GET_TIME:
-            rc = ksyscall_sys_get_time();
+    // Pass only the arguments the handler takes
+    switch (entry->nargs) {
+        case 0:
+            rc = entry->func();
             break;
 
-        case SYSCALL_PROC_GET_PID:
-            rc = ksyscall_proc_get_pid();
+        case 1:
+            rc = entry->func(arg1);
             break;
 
-        case SYSCALL_PROC_GET_NAME:
-            rc = ksyscall_proc_get_name((char *)arg1);
+        case 2:
+            rc = entry->func(arg1, arg2);
             break;
 
-        case SYSCALL_MUTEX_ALLOC:
-            rc = ksyscall_mutex_alloc();
+        default:
+            rc = entry->func(arg1, arg2, arg3);
             break;
+    }
 
-        case SYSCALL_MUTEX_FREE:
-            rc = ksyscall_mutex_free((int)arg1);
-            break;
+    entry->calls++;
+    entry->cycles += tsc_read() - start;
 
-        case SYSCALL_MUTEX_LOCK:
-            rc = ksyscall_mutex_lock((int)arg1);
-            break;
+    return rc;
+}
 
-        case SYSCALL_MUTEX_UNLOCK:
-            rc = ksyscall_mutex_unlock((int)arg1);
-            break;
+/**
+ * System call kernel handler: sys_read_key
+ * Reads a key typed on the keyboard; the calling process waits if no key
+ * has been typed yet
+ *
+ * @param key - where to store the key
+ * @return 0 on success, -1 on error
+ */
+int ksyscall_sys_read_key(char *key) {
+    return kbd_read(key);
+}
 
-        case SYSCALL_MSG_SEND:
-            rc = ksyscall_msg_send((int) arg1, (msg_t*) arg2);
-            break;
+/**
+ * System call kernel handler: sys_write
+ * Writes characters to the serial console; each line is sent once it is
+ * complete
+ *
+ * @param buf - characters to write
+ * @param len - number of characters
+ * @return number of characters written, -1 on error
+ */
+int ksyscall_sys_write(char *buf, int len) {
+    if (!buf || len < 0) {
+        return -1;
+    }
 
-        case SYSCALL_MSG_RECV:
-            rc = ksyscall_msg_recv((int) arg1, (msg_t*) arg2);
-            break;
+    return uart_proc_write(current, buf, len);
+}
 
-        default:
-            panic("Invalid system call %d!", syscall);
+/**
+ * System call kernel handler: batch
+ * Runs several system calls in order, stopping after the first one that
+ * blocks (or otherwise gives up the CPU) or that fails while flagged
+ * SYSCALL_BATCH_STOP_ON_ERROR
+ *
+ * @param calls - system calls to run; each return value is stored with it
+ * @param count - number of system calls
+ * @return number of system calls run, -1 on error
+ */
+int ksyscall_batch(syscall_batch_t *calls, int count) {
+    proc_t *proc = current;
+    int pid = current->pid;
+    int i;
+
+    if (!calls || count < 0 || count > SYSCALL_BATCH_MAX) {
+        return -1;
     }
 
-    return rc;
+    for (i = 0; i < count; i++) {
+        // Batches cannot be nested, and the results of a timed receive or
+        // of waiting on several mailboxes are only known once the process
+        // resumes
+        if (calls[i].syscall == SYSCALL_BATCH || calls[i].syscall == SYSCALL_MSG_RECV_TIMEOUT ||
+            calls[i].syscall == SYSCALL_MSG_SELECT) {
+            calls[i].rc = -1;
+        } else {
+            calls[i].rc = ksyscall_handler(calls[i].syscall, calls[i].args[0],
+                                           calls[i].args[1], calls[i].args[2]);
+
+            // Nothing more can be done for a process that exited
+            if (proc->pid != pid || proc->state == NONE) {
+                return -1;
+            }
+
+            // Stop once the process blocks; the batch returns when it resumes
+            if (current != proc || proc->state != ACTIVE) {
+                proc->trapframe->eax = i + 1;
+                return i + 1;
+            }
+        }
+
+        // Skip the rest of the batch if the caller depends on this call
+        if ((calls[i].flags & SYSCALL_BATCH_STOP_ON_ERROR) && calls[i].rc < 0) {
+            return i + 1;
+        }
+    }
+
+    return count;
 }
 
+/**
+ * System call kernel handler: sys_get_syscall_stats
+ * Returns the usage statistics of a system call
+ *
+ * @param syscall - system call number
+ * @param stats - pointer to the statistics to fill in
+ * @return 0 on success, -1 on error
+ */
+int ksyscall_sys_get_syscall_stats(int syscall, syscall_stats_t *stats) {
+    ksyscall_t *entry;
+
+    if (syscall < 0 || syscall >= SYSCALL_MAX || !stats) {
+        return -1;
+    }
+
+    entry = &ksyscalls[syscall];
+
+    if (!entry->func) {
+        return -1;
+    }
+
+    memset(stats, 0, sizeof(syscall_stats_t));
+    strncpy(stats->name, entry->name, SYSCALL_NAME_LEN - 1);
+    stats->nargs  = entry->nargs;
+    stats->calls  = entry->calls;
+    stats->cycles = entry->cycles;
+
+    return 0;
+}
 
 /**
  * System call kernel handler: sys_get_time
@@ -101,7 +233,27 @@ int ksyscall_handler(int syscall, unsigned int arg1, unsigned int arg2, unsigned
  * @return current system time (in seconds)
  */
 int ksyscall_sys_get_time(void) {
-    return system_time / CLK_TCK;
+    return system_time / TIMER_HZ;
+}
+
+/**
+ * System call kernel handler: sys_get_time_ms
+ * Returns the current system time (in milliseconds) to the caller
+ *
+ * @return current system time (in milliseconds)
+ */
+int ksyscall_sys_get_time_ms(void) {
+    return timer_ticks_to_ms(system_time);
+}
+
+/**
+ * System call kernel handler: sys_get_hz
+ * Returns the timer tick rate to the caller
+ *
+ * @return number of ticks per second
+ */
+int ksyscall_sys_get_hz(void) {
+    return TIMER_HZ;
 }
 
 /**
@@ -143,27 +295,162 @@ int ksyscall_proc_get_name(char *name) {
 }
 
 /**
- * System call kernel handler: sleep
- * Immediately unschedules a process and puts it in a sleep state
+ * System call kernel handler: proc_set_priority
+ * Sets the base scheduling priority of a process
  *
- * @param secs - number of seconds for the process to sleep
+ * @param pid - process id
+ * @param priority - priority (PROC_PRIORITY_HIGH to PROC_PRIORITY_LOW)
  * @return 0 on success, -1 on error
  */
-int ksyscall_sleep(int time) {
+int ksyscall_proc_set_priority(int pid, int priority) {
+    proc_t *proc;
+
+    proc = kproc_lookup(pid);
+
+    if (!proc) {
+        return -1;
+    }
+
+    return scheduler_set_priority(proc, priority);
+}
+
+/**
+ * System call kernel handler: proc_get_priority
+ * Returns the base scheduling priority of a process
+ *
+ * @param pid - process id
+ * @return priority on success, -1 on error
+ */
+int ksyscall_proc_get_priority(int pid) {
+    proc_t *proc;
+
+    proc = kproc_lookup(pid);
+
+    if (!proc) {
+        return -1;
+    }
+
+    return proc->priority;
+}
+
+/**
+ * System call kernel handler: proc_set_tickets
+ * Sets the stride scheduling tickets of a process
+ *
+ * @param pid - process id
+ * @param tickets - number of tickets (0 to stop using stride scheduling)
+ * @return 0 on success, -1 on error
+ */
+int ksyscall_proc_set_tickets(int pid, int tickets) {
+    proc_t *proc;
+
+    proc = kproc_lookup(pid);
+
+    if (!proc) {
+        return -1;
+    }
+
+    return scheduler_set_tickets(proc, tickets);
+}
+
+/**
+ * System call kernel handler: proc_set_timeslice
+ * Sets the time slice of a process
+ *
+ * @param pid - process id
+ * @param ticks - time slice in ticks (0 for the default time slice)
+ * @param adaptive - non-zero to adapt the time slice to the process
+ * @return 0 on success, -1 on error
+ */
+int ksyscall_proc_set_timeslice(int pid, int ticks, int adaptive) {
+    proc_t *proc;
+
+    proc = kproc_lookup(pid);
+
+    if (!proc) {
+        return -1;
+    }
+
+    return scheduler_set_timeslice(proc, ticks, adaptive);
+}
+
+/**
+ * System call kernel handler: proc_get_usage
+ * Returns the CPU time used by a process
+ *
+ * @param pid - process id
+ * @param usage - pointer to the usage to fill in
+ * @return 0 on success, -1 on error
+ */
+int ksyscall_proc_get_usage(int pid, proc_usage_t *usage) {
+    proc_t *proc;
+
+    if (!usage) {
+        return -1;
+    }
+
+    proc = kproc_lookup(pid);
+
+    if (!proc) {
+        return -1;
+    }
+
+    usage->cycles = proc->cycles;
+    usage->usecs  = tsc_to_us(proc->cycles);
+    usage->ticks  = proc->cpu_time;
+
+    return 0;
+}
+
+/**
+ * System call kernel handler: proc_set_rt
+ * Sets the real-time scheduling parameters of a process
+ *
+ * @param pid - process id
+ * @param params - pointer to the real-time parameters
+ * @return 0 on success, -1 on error or if the process cannot be admitted
+ */
+int ksyscall_proc_set_rt(int pid, rt_params_t *params) {
+    proc_t *proc;
+
+    if (!params) {
+        return -1;
+    }
+
+    proc = kproc_lookup(pid);
+
+    if (!proc || proc_is_idle(proc)) {
+        return -1;
+    }
+
+    return scheduler_set_rt(proc, params->period, params->budget, params->deadline);
+}
+
+/**
+ * Immediately unschedules the current process and puts it in a sleep state
+ *
+ * @param ticks - number of ticks for the process to sleep
+ * @return 0 on success, -1 on error
+ */
+static int ksyscall_sleep_ticks(int ticks) {
     if (!current) {
         panic_warn("Invalid process!");
         return -1;
     }
 
-    // Set the current state to SLEEPING
-    current->state = SLEEPING;
+    if (ticks < 0) {
+        return -1;
+    }
 
     // Reset the current process' active time
     current->active_time = 0;
 
-    // Set the current process' wake time
+    // End the current real-time job; the process runs again at its next release
+    current->rt_remaining = 0;
+
+    // Set the current state to SLEEPING and queue it with the wake time
     // This should be when the scheduler will wake it up
-    current->wake_time = system_time + (CLK_TCK * time);
+    scheduler_sleep(current, system_time + ticks);
 
     // Ensure that the current process will be unscheduled
     current = NULL;
@@ -171,6 +458,44 @@ int ksyscall_sleep(int time) {
     return 0;
 }
 
+/**
+ * System call kernel handler: sleep
+ * Immediately unschedules a process and puts it in a sleep state
+ *
+ * @param secs - number of seconds for the process to sleep
+ * @return 0 on success, -1 on error
+ */
+int ksyscall_sleep(int time) {
+    // Refuse times that cannot be counted in ticks
+    if (time < 0 || time > TIMER_SECS_MAX) {
+        return -1;
+    }
+
+    return ksyscall_sleep_ticks(time * TIMER_HZ);
+}
+
+/**
+ * System call kernel handler: msleep
+ * Immediately unschedules a process and puts it in a sleep state
+ *
+ * @param ms - number of milliseconds for the process to sleep
+ * @return 0 on success, -1 on error
+ */
+int ksyscall_msleep(int ms) {
+    return ksyscall_sleep_ticks(timer_ms_to_ticks(ms));
+}
+
+/**
+ * System call kernel handler: usleep
+ * Immediately unschedules a process and puts it in a sleep state
+ *
+ * @param us - number of microseconds for the process to sleep
+ * @return 0 on success, -1 on error
+ */
+int ksyscall_usleep(int us) {
+    return ksyscall_sleep_ticks(timer_us_to_ticks(us));
+}
+
 /**
  * System call kernel handler: yield
  * Immediately unschedules a process
@@ -189,6 +514,9 @@ int ksyscall_yield(void) {
     // Reset the current process' active time
     current->active_time = 0;
 
+    // End the current real-time job; the process runs again at its next release
+    current->rt_remaining = 0;
+
     // Add the current process back to the scheduer
     scheduler_add(current);
 
@@ -273,17 +601,20 @@ int ksyscall_mutex_unlock(int id) {
 }
 
 /**
- * System call kernel handler: msg_send
  * Sends a message to the specified mailbox
+ * If a process is waiting for a message, the message is copied straight
+ * into its buffer (the mailbox is always empty while processes wait on
+ * it) and, if donating, the calling process gives the rest of its time
+ * slice to the receiver so the receiver runs next.
+ * Only the given number of bytes of data are sent. A reference to the
+ * given message buffer (if any) is moved from the caller to the message.
  *
  * @return -1 on error, 0 on success
  */
-int ksyscall_msg_send(int mbox, msg_t *msg) {
-    proc_t *waiting_proc;
+static int ksyscall_msg_deliver(int mbox, msg_t *msg, int size, int buf, int donate) {
+    proc_t *waiting_proc = NULL;
     msg_t *msg_dest;
-    int pid;
-    int i;
-    
+
     // Ensure that the mailbox is valid, warn/return error if not
     if(mbox >= MBOX_MAX || mbox < 0){
         panic_warn("Invalid mailbox number");
@@ -296,66 +627,135 @@ int ksyscall_msg_send(int mbox, msg_t *msg) {
         return -1;
     }
 
+    // Ensure that the message size is valid, warn/return error if not
+    if(size < 0 || size > MSG_SIZE){
+        panic_warn("Invalid message size");
+        return -1;
+    }
+
     // Set the sender of the message to the calling process' PID
     msg->sender = current->pid;
 
+    // Set the number of bytes of data sent
+    msg->size = size;
+
+    // Pass the caller's reference to the message buffer with the message
+    if(buf && msgbuf_send(current, buf) != 0){
+        panic_warn("Invalid message buffer");
+        return -1;
+    }
+
+    msg->buf = buf;
+
     // Set the time the message was sent (in seconds)
-    msg->time_sent = system_time/CLK_TCK;
+    msg->time_sent = system_time/TIMER_HZ;
 
-    // Enqueue the message to the mailbox
+    // Dequeue the process waiting longest from the wait list (if any)
+    waiting_proc = proc_list_pop(&mailboxes[mbox].wait_list);
+
+    // If there is no process waiting to receive a message, enqueue the
+    // message to the mailbox
     // Treat an error here as a warning and return an error (i.e. mailbox
     // could be full)
-    if(mbox_queue_in(mbox, msg) != 0){
-        panic_warn("Error trying to enqueue the function.");
-        return -1;
-    }
+    if(!waiting_proc){
+        if(mbox_queue_in(mbox, msg) != 0){
+            // The caller keeps the message buffer
+            if(buf){
+                msgbuf_receive(current, buf);
+            }
 
-    // When sending a message, if there is a process waiting to receive a
-    // message, immediately handle it
-    if(!queue_is_empty(&(mailboxes[mbox].wait_queue))){
-        //   Dequeue the waiting process from the wait queue
-        if(queue_out(&(mailboxes[mbox].wait_queue), &pid) == -1){
-            panic_warn("Unable to dequeue process from wait queue");
+            panic_warn("Error trying to enqueue the function.");
             return -1;
         }
-        
-        //   Obtain the process from the PID
-        for (i = 0; i < PROC_MAX; i++) {
-            waiting_proc = &proc_table[i];
-            if (waiting_proc->pid == pid) {
-                //   Update the waiting process' state to running
-                //   Add the process back to the scheduler
-                scheduler_add(waiting_proc);
-                waiting_proc->state = RUNNING;
-                break;
-            }
+
+        // Wake the process waiting longest for any of its mailboxes to
+        // have a message, telling it which one does
+        waiting_proc = mbox_notify_pop(mbox);
+
+        if(waiting_proc){
+            waiting_proc->trapframe->eax = mbox;
+            scheduler_add(waiting_proc);
         }
 
+        return 0;
+    }
 
-        //   Obtain the message pointer for the receiving process (should exist on
-        //   the calling process' trapframe)
-        msg_dest = (msg_t *)waiting_proc->trapframe->ecx;
-        //    Dequeue the message from the mailbox
-        mbox_queue_out(mbox, msg_dest);
-        //    Set the time the message was received (in seconds)
-        msg->time_received = system_time;
+    // Copy the message into the buffer the receiving process saved when it
+    // blocked, bypassing the mailbox
+    msg_dest = waiting_proc->msg_dest;
+    waiting_proc->msg_dest = NULL;
+    mbox_msg_copy(msg_dest, msg, waiting_proc->msg_size);
+
+    // Set the time the message was received
+    msg_dest->time_received = system_time;
+
+    // The receiver now holds the reference to the message buffer
+    if(buf){
+        msgbuf_receive(waiting_proc, buf);
+    }
+
+    // A receiver waiting with a timeout is still in the sleep queue and
+    // is told that its message arrived in time
+    if(waiting_proc->sleep_pos != 0){
+        scheduler_remove(waiting_proc);
+        waiting_proc->trapframe->eax = 0;
     }
 
-    // If there is no process waiting to receive a message, there is nothing
-    // else to do since the message has been queued into the mailbox
+    // Add the process back to the scheduler (updates its state)
+    scheduler_add(waiting_proc);
+
+    // Switch to the receiver in place of the calling process
+    if(donate && scheduler_donate(current, waiting_proc) == 0){
+        current->trapframe->eax = 0;
+        scheduler_add(current);
+        current = NULL;
+    }
 
     return 0;
 }
 
 /**
- * System call kernel handler: msg_recv
+ * System call kernel handler: msg_send
+ * Sends a message to the specified mailbox
+ *
+ * @return -1 on error, 0 on success
+ */
+int ksyscall_msg_send(int mbox, msg_t *msg) {
+    return ksyscall_msg_deliver(mbox, msg, MSG_SIZE, 0, 0);
+}
+
+/**
+ * System call kernel handler: msg_send_size
+ * Sends the given number of bytes of a message to the specified mailbox
+ *
+ * @return -1 on error, 0 on success
+ */
+int ksyscall_msg_send_size(int mbox, msg_t *msg, int size) {
+    return ksyscall_msg_deliver(mbox, msg, size, 0, 0);
+}
+
+/**
+ * System call kernel handler: msg_send_donate
+ * Sends a message to the specified mailbox and, if a process was waiting
+ * to receive it, runs the receiver for the rest of the time slice
+ *
+ * @return -1 on error, 0 on success
+ */
+int ksyscall_msg_send_donate(int mbox, msg_t *msg) {
+    return ksyscall_msg_deliver(mbox, msg, MSG_SIZE, 0, 1);
+}
+
+/**
  * Receives a message from the specified mailbox
  * Blocking/synchronous
+ * Only the bytes of data sent, up to the given size, are copied; the
+ * message size is set to the number of bytes received.
+ * If the mailbox is empty, the calling process waits for up to the given
+ * number of ticks (forever if negative, not at all if 0).
  *
- * @return -1 on error, 0 on success
+ * @return -1 on error or if no message was received, 0 on success
  */
-int ksyscall_msg_recv(int mbox, msg_t *msg) {
-    
+static int ksyscall_msg_take(int mbox, msg_t *msg, int size, int timeout) {
     // Ensure that the mailbox is valid, warn/return error if not
     if(mbox >= MBOX_MAX || mbox < 0){
         panic_warn("Invalid mailbox number");
@@ -368,27 +768,203 @@ int ksyscall_msg_recv(int mbox, msg_t *msg) {
         return -1;
     }
 
+    // Ensure that the message size is valid, warn/return error if not
+    if(size < 0 || size > MSG_SIZE){
+        panic_warn("Invalid message size");
+        return -1;
+    }
+
     // Check if the mailbox is empty
     if(mailboxes[mbox].size == 0){
+        // Return right away if the caller does not want to wait
+        if (timeout == 0) {
+            return -1;
+        }
+
         // If empty, we need to remove the current process from the scheduler
-        // and add it to the mailbox wait queue
+        // and add it to the mailbox wait list
         // Treat errors here as fatal/panic
-        if (queue_in(&mailboxes[mbox].wait_queue, current->pid) != 0) {
-            panic("Unable to add process to mail box wait queue");
+        if (proc_list_push(&mailboxes[mbox].wait_list, current) != 0) {
+            panic("Unable to add process to mail box wait list");
+        }
+        current->msg_dest = msg;
+        current->msg_size = size;
+
+        // A process waiting with a timeout also sleeps until the timeout;
+        // if it wakes up first it is taken off the wait list and the -1
+        // returned here stands (a message arriving returns 0 instead)
+        if (timeout > 0) {
+            scheduler_sleep(current, system_time + timeout);
+            return -1;
         }
+
         current->state = WAITING;
         scheduler_remove(current);
-    
+
     }else{
         // if not empty, we need to queue a message out of the mailbox
         // set the message received time (in seconds)
         // Treat errors here at fatal/panic
-        if (mbox_queue_out(mbox, msg) != 0) {
+        if (mbox_queue_out(mbox, msg, size) != 0) {
             panic("Unable to dequeue message from mailbox");
         }
         msg->time_received = system_time;
+
+        // The receiver now holds the reference to the message buffer
+        if (msg->buf) {
+            msgbuf_receive(current, msg->buf);
+        }
     }
 
 
     return 0;
 }
+
+/**
+ * System call kernel handler: msg_recv
+ * Receives a message from the specified mailbox
+ * Blocking/synchronous
+ *
+ * @return -1 on error, 0 on success
+ */
+int ksyscall_msg_recv(int mbox, msg_t *msg) {
+    return ksyscall_msg_take(mbox, msg, MSG_SIZE, -1);
+}
+
+/**
+ * System call kernel handler: msg_recv_size
+ * Receives a message from the specified mailbox, copying at most the
+ * given number of bytes of data
+ * Blocking/synchronous
+ *
+ * @return -1 on error, 0 on success
+ */
+int ksyscall_msg_recv_size(int mbox, msg_t *msg, int size) {
+    return ksyscall_msg_take(mbox, msg, size, -1);
+}
+
+/**
+ * System call kernel handler: msg_try_recv
+ * Receives a message from the specified mailbox if one is waiting
+ * Non-blocking
+ *
+ * @return -1 on error or if the mailbox is empty, 0 on success
+ */
+int ksyscall_msg_try_recv(int mbox, msg_t *msg) {
+    return ksyscall_msg_take(mbox, msg, MSG_SIZE, 0);
+}
+
+/**
+ * System call kernel handler: msg_recv_timeout
+ * Receives a message from the specified mailbox, waiting up to the given
+ * number of milliseconds for one to arrive
+ *
+ * @return -1 on error or timeout, 0 on success
+ */
+int ksyscall_msg_recv_timeout(int mbox, msg_t *msg, int ms) {
+    if (ms < 0) {
+        return -1;
+    }
+
+    return ksyscall_msg_take(mbox, msg, MSG_SIZE, ms ? timer_ms_to_ticks(ms) : 0);
+}
+
+/**
+ * System call kernel handler: msg_select
+ * Waits until any of the given mailboxes has a message
+ * If none of the mailboxes has a message, the calling process is added to
+ * the notification list of each of them and is only woken (with the
+ * mailbox number as the result) by the first message sent to any of them.
+ *
+ * @param mboxes - mailbox numbers
+ * @param count - number of mailboxes
+ * @return -1 on error, otherwise the first mailbox with a message
+ */
+int ksyscall_msg_select(int *mboxes, int count) {
+    int i;
+
+    // Ensure that the mailbox list is valid, warn/return error if not
+    if(mboxes == NULL || count <= 0 || count > MBOX_MAX){
+        panic_warn("Invalid mailbox list");
+        return -1;
+    }
+
+    for(i = 0; i < count; i++){
+        if(mboxes[i] >= MBOX_MAX || mboxes[i] < 0){
+            panic_warn("Invalid mailbox number");
+            return -1;
+        }
+
+        // Return the first mailbox that already has a message
+        if(mailboxes[mboxes[i]].size > 0){
+            return mboxes[i];
+        }
+    }
+
+    // Wait on every mailbox; the first message sent to any of them sets
+    // the result and takes the process off all of the lists
+    // (a mailbox listed more than once is only waited on once)
+    for(i = 0; i < count; i++){
+        mbox_notify_add(mboxes[i], current);
+    }
+
+    current->state = WAITING;
+    scheduler_remove(current);
+
+    return -1;
+}
+
+/**
+ * System call kernel handler: msg_send_buf
+ * Sends a message to the specified mailbox along with a message buffer,
+ * passing the caller's reference to the buffer instead of copying it
+ *
+ * @return -1 on error, 0 on success
+ */
+int ksyscall_msg_send_buf(int mbox, msg_t *msg, int buf) {
+    if (buf <= 0) {
+        return -1;
+    }
+
+    return ksyscall_msg_deliver(mbox, msg, 0, buf, 0);
+}
+
+/**
+ * System call kernel handler: msg_buf_alloc
+ * Allocates a message buffer
+ *
+ * @return buffer handle, -1 on error
+ */
+int ksyscall_msg_buf_alloc(int size, void **data) {
+    return msgbuf_alloc(current, size, data);
+}
+
+/**
+ * System call kernel handler: msg_buf_map
+ * Looks up the address of a message buffer held by the caller
+ *
+ * @return size of the buffer, -1 on error
+ */
+int ksyscall_msg_buf_map(int buf, void **data) {
+    return msgbuf_map(current, buf, data);
+}
+
+/**
+ * System call kernel handler: msg_buf_dup
+ * Adds a reference to a message buffer held by the caller
+ *
+ * @return 0 on success, -1 on error
+ */
+int ksyscall_msg_buf_dup(int buf) {
+    return msgbuf_dup(current, buf);
+}
+
+/**
+ * System call kernel handler: msg_buf_release
+ * Releases a reference to a message buffer held by the caller
+ *
+ * @return 0 on success, -1 on error
+ */
+int ksyscall_msg_buf_release(int buf) {
+    return msgbuf_release(current, buf);
+}
@@ -4,15 +4,35 @@
 #include "syscall_defs.h"
 #include "msg.h"
 
+/* System call dispatch table entry */
+typedef struct ksyscall_t {
+    char *name;                     // System call name
+    int nargs;                      // Number of arguments the handler takes
+    int (*func)();                  // Handler function
+    unsigned int calls;             // Number of calls made
+    unsigned long long cycles;      // Time spent in the handler (TSC cycles)
+} ksyscall_t;
+
+/* System call dispatch table */
+extern ksyscall_t ksyscalls[SYSCALL_MAX];
+
 /* System Call Handler */
 int ksyscall_handler(int syscall, unsigned int arg1, unsigned int arg2, unsigned int arg3);
 
 /* System information */
 int ksyscall_sys_get_time(void);
+int ksyscall_sys_get_time_ms(void);
+int ksyscall_sys_get_hz(void);
+int ksyscall_sys_get_syscall_stats(int syscall, syscall_stats_t *stats);
+int ksyscall_batch(syscall_batch_t *calls, int count);
+int ksyscall_sys_read_key(char *key);
+int ksyscall_sys_write(char *buf, int len);
 
 /* Process functionality */
 int ksyscall_yield(void);
 int ksyscall_sleep(int time);
+int ksyscall_msleep(int ms);
+int ksyscall_usleep(int us);
 
 int ksyscall_proc_exec(char *proc_name, void *proc_ptr);
 int ksyscall_proc_exit(void);
@@ -21,6 +41,14 @@ int ksyscall_proc_exit(void);
 int ksyscall_proc_get_pid(void);
 int ksyscall_proc_get_name(char *name);
 
+/* Process scheduling */
+int ksyscall_proc_set_priority(int pid, int priority);
+int ksyscall_proc_get_priority(int pid);
+int ksyscall_proc_set_tickets(int pid, int tickets);
+int ksyscall_proc_set_timeslice(int pid, int ticks, int adaptive);
+int ksyscall_proc_get_usage(int pid, proc_usage_t *usage);
+int ksyscall_proc_set_rt(int pid, rt_params_t *params);
+
 /* Mutex functions */
 int ksyscall_mutex_alloc(void);
 int ksyscall_mutex_free(int id);
@@ -29,6 +57,17 @@ int ksyscall_mutex_unlock(int id);
 
 /* Message functions */
 int ksyscall_msg_send(int mbox, msg_t *msg);
+int ksyscall_msg_send_donate(int mbox, msg_t *msg);
 int ksyscall_msg_recv(int mbox, msg_t *msg);
+int ksyscall_msg_send_size(int mbox, msg_t *msg, int size);
+int ksyscall_msg_recv_size(int mbox, msg_t *msg, int size);
+int ksyscall_msg_send_buf(int mbox, msg_t *msg, int buf);
+int ksyscall_msg_buf_alloc(int size, void **data);
+int ksyscall_msg_buf_map(int buf, void **data);
+int ksyscall_msg_buf_dup(int buf);
+int ksyscall_msg_buf_release(int buf);
+int ksyscall_msg_try_recv(int mbox, msg_t *msg);
+int ksyscall_msg_recv_timeout(int mbox, msg_t *msg, int ms);
+int ksyscall_msg_select(int *mboxes, int count);
 
 #endif
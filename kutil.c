@@ -50,3 +50,33 @@ void panic_warn(char *msg, ...) {
     breakpoint();
 }
 
+
+/**
+ * Scales a value by a fraction without 64-bit division, which would need
+ * the libgcc helpers the kernel is not linked with
+ * The fraction num / den is split into a whole part and a remainder; the
+ * remainder is turned into a 32-bit binary fraction by long division.
+ * @param value - value to scale
+ * @param num   numerator of the fraction
+ * @param den   denominator of the fraction (1 to 2^31 - 1)
+ * @return value * num / den (rounded down, to within value / 2^32)
+ */
+unsigned long long mul_div(unsigned long long value, unsigned int num, unsigned int den) {
+    unsigned int rem = num % den;
+    unsigned int frac = 0;
+    int i;
+
+    for (i = 0; i < 32; i++) {
+        rem <<= 1;
+        frac <<= 1;
+
+        if (rem >= den) {
+            rem -= den;
+            frac |= 1;
+        }
+    }
+
+    return value * (num / den)
+           + (value >> 32) * frac
+           + (((value & 0xffffffff) * frac) >> 32);
+}
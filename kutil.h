@@ -36,4 +36,13 @@ void panic_warn(char *msg, ...);
  * Dumps the process list
  */
 void kernel_dump();
+
+/**
+ * Scales a value by a fraction without 64-bit division
+ * @param value - value to scale
+ * @param num   numerator of the fraction
+ * @param den   denominator of the fraction (1 to 2^31 - 1)
+ * @return value * num / den (rounded down, to within value / 2^32)
+ */
+unsigned long long mul_div(unsigned long long value, unsigned int num, unsigned int den);
 #endif
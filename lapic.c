@@ -0,0 +1,302 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2021
+ *
+ * Local APIC
+ */
+
+#include <spede/stdio.h>
+
+#include "interrupts.h"
+#include "kutil.h"
+#include "lapic.h"
+#include "smp.h"
+#include "timer.h"
+#include "tsc.h"
+#include "x86.h"
+
+#define LAPIC_SVR_ENABLE        0x100       // APIC software enable
+#define LAPIC_ICR_PENDING       0x1000      // IPI delivery pending
+#define LAPIC_ICR_INIT_ALL      0x000c4500  // INIT, assert, all excluding self
+#define LAPIC_ICR_STARTUP_ALL   0x000c4600  // STARTUP, all excluding self
+#define LAPIC_TIMER_ONESHOT     0x00000     // Timer one-shot mode
+#define LAPIC_TIMER_PERIODIC    0x20000     // Timer periodic mode
+#define LAPIC_TIMER_TSC_DEADLINE 0x40000    // Timer TSC-deadline mode
+#define LAPIC_TIMER_DIV_16      0x3         // Divide the bus clock by 16
+
+// Calibration period (1/100th of a second)
+#define LAPIC_CAL_HZ    100
+
+// Number of local APIC timer counts per tick
+unsigned int lapic_timer_count;
+
+// Number of time stamp counter cycles per tick
+unsigned long long lapic_tsc_tick;
+
+/**
+ * Reads a local APIC register
+ * @param reg - register offset
+ * @return register value
+ */
+unsigned int lapic_read(int reg) {
+    return *(volatile unsigned int *)(LAPIC_BASE + reg);
+}
+
+/**
+ * Writes a local APIC register
+ * @param reg - register offset
+ * @param value - value to write
+ */
+void lapic_write(int reg, unsigned int value) {
+    *(volatile unsigned int *)(LAPIC_BASE + reg) = value;
+}
+
+/**
+ * Enables the local APIC of the executing CPU
+ */
+void lapic_init() {
+    // Software enable the APIC and route spurious interrupts
+    lapic_write(LAPIC_SVR, LAPIC_SVR_ENABLE | LAPIC_SPURIOUS_INTR);
+
+    // Accept all interrupts
+    lapic_write(LAPIC_TPR, 0);
+}
+
+/**
+ * Signals the end of the current interrupt to the local APIC
+ */
+void lapic_eoi() {
+    lapic_write(LAPIC_EOI, 0);
+}
+
+/**
+ * Sends an interrupt command and waits for it to be delivered
+ */
+static void lapic_ipi(unsigned int icr) {
+    lapic_write(LAPIC_ICR_HIGH, 0);
+    lapic_write(LAPIC_ICR_LOW, icr);
+
+    while (lapic_read(LAPIC_ICR_LOW) & LAPIC_ICR_PENDING);
+}
+
+/**
+ * Sends an INIT IPI to all other CPUs
+ */
+void lapic_ipi_init_all() {
+    lapic_ipi(LAPIC_ICR_INIT_ALL);
+}
+
+/**
+ * Sends a STARTUP IPI to all other CPUs
+ * @param vector - page number (address / 4096) where the CPUs start executing
+ */
+void lapic_ipi_startup_all(int vector) {
+    lapic_ipi(LAPIC_ICR_STARTUP_ALL | (vector & 0xff));
+}
+
+/**
+ * Measures the local APIC timer against the PIT
+ * PIT channel 2 is used as a one-shot reference so the tick on channel 0
+ * is left untouched
+ */
+static void lapic_timer_calibrate() {
+    unsigned int elapsed;
+
+    timer_ref_start(LAPIC_CAL_HZ);
+
+    // Let the APIC timer count down from its maximum value
+    lapic_write(LAPIC_TIMER_DIV, LAPIC_TIMER_DIV_16);
+    lapic_write(LAPIC_TIMER_INIT, 0xffffffff);
+
+    timer_ref_wait();
+
+    elapsed = 0xffffffff - lapic_read(LAPIC_TIMER_CUR);
+
+    // Stop the APIC timer
+    lapic_write(LAPIC_TIMER_INIT, 0);
+
+    lapic_timer_count = elapsed * LAPIC_CAL_HZ / TIMER_HZ;
+
+    printf("Local APIC timer: %u counts per tick\n", lapic_timer_count);
+}
+
+/**
+ * Queries if the executing CPU has a local APIC
+ */
+static int lapic_present() {
+    unsigned int a, b, c, d;
+
+    cpuid(CPUID_FEATURES, a, b, c, d);
+
+    return (d & CPUID_EDX_APIC) != 0;
+}
+
+/**
+ * Detects and calibrates the local APIC timer
+ */
+static int lapic_timer_probe() {
+    if (!lapic_present()) {
+        return -1;
+    }
+
+    lapic_init();
+    lapic_timer_calibrate();
+
+    return lapic_timer_count > 0 ? 0 : -1;
+}
+
+/**
+ * Starts the local APIC timer of the executing CPU, generating periodic
+ * interrupts at TIMER_HZ
+ */
+static void lapic_timer_set_periodic() {
+    lapic_write(LAPIC_TIMER_DIV, LAPIC_TIMER_DIV_16);
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_TIMER_PERIODIC | LAPIC_TIMER_INTR);
+    lapic_write(LAPIC_TIMER_INIT, lapic_timer_count);
+}
+
+/**
+ * Programs the local APIC timer of the executing CPU to generate a single
+ * interrupt after a delay
+ * @param us - delay in microseconds
+ */
+static void lapic_timer_set_oneshot(int us) {
+    lapic_write(LAPIC_TIMER_DIV, LAPIC_TIMER_DIV_16);
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_TIMER_ONESHOT | LAPIC_TIMER_INTR);
+    lapic_write(LAPIC_TIMER_INIT,
+                (unsigned int)mul_div(us, lapic_timer_count, TIMER_TICK_US));
+}
+
+/**
+ * Reads the time left before the one-shot interrupt
+ * @return microseconds remaining, -1 if the count already reached zero
+ */
+static int lapic_timer_remaining() {
+    unsigned int count = lapic_read(LAPIC_TIMER_CUR);
+
+    if (count == 0) {
+        return -1;
+    }
+
+    return (int)mul_div(count, TIMER_TICK_US, lapic_timer_count);
+}
+
+/**
+ * Detects the TSC-deadline mode of the local APIC timer
+ * The time stamp counter must already be calibrated
+ */
+static int lapic_tsc_deadline_probe() {
+    unsigned int a, b, c, d;
+
+    if (!lapic_present() || tsc_khz == 0) {
+        return -1;
+    }
+
+    cpuid(CPUID_FEATURES, a, b, c, d);
+
+    if (!(c & CPUID_ECX_TSC_DEADLINE)) {
+        return -1;
+    }
+
+    lapic_init();
+
+    lapic_tsc_tick = mul_div(tsc_khz, 1000, TIMER_HZ);
+
+    return 0;
+}
+
+/**
+ * Arms the TSC deadline of the executing CPU
+ * @param deadline - time stamp at which the interrupt is raised
+ */
+static void lapic_tsc_deadline_arm(unsigned long long deadline) {
+    // The timer mode must be selected before the deadline is written
+    lapic_write(LAPIC_LVT_TIMER, LAPIC_TIMER_TSC_DEADLINE | LAPIC_TIMER_INTR);
+    msr_write(MSR_TSC_DEADLINE, deadline);
+}
+
+/**
+ * Starts the periodic tick of the executing CPU; the TSC-deadline mode has
+ * no periodic mode so the next deadline is armed on every tick
+ */
+static void lapic_tsc_deadline_set_periodic() {
+    cpu_t *cpu = cpu_this();
+
+    cpu->clock_next = tsc_read() + lapic_tsc_tick;
+    lapic_tsc_deadline_arm(cpu->clock_next);
+}
+
+/**
+ * Arms a single interrupt on the executing CPU after a delay
+ * @param us - delay in microseconds
+ */
+static void lapic_tsc_deadline_set_oneshot(int us) {
+    cpu_this()->clock_next = 0;
+    lapic_tsc_deadline_arm(tsc_read() + tsc_from_us(us));
+}
+
+/**
+ * Reads the time left before the one-shot interrupt
+ * @return microseconds remaining, -1 if the deadline already passed
+ */
+static int lapic_tsc_deadline_remaining() {
+    unsigned long long deadline = msr_read(MSR_TSC_DEADLINE);
+    unsigned long long now = tsc_read();
+
+    // The deadline register is cleared once the interrupt is raised
+    if (deadline == 0 || deadline <= now) {
+        return -1;
+    }
+
+    return (int)tsc_to_us(deadline - now);
+}
+
+/**
+ * Re-arms the periodic tick (if running) and signals the end of the
+ * interrupt
+ */
+static void lapic_tsc_deadline_ack() {
+    cpu_t *cpu = cpu_this();
+    unsigned long long now;
+
+    if (cpu->clock_next) {
+        cpu->clock_next += lapic_tsc_tick;
+        now = tsc_read();
+
+        // Skip ticks that were missed rather than delivering them back to back
+        if (cpu->clock_next <= now) {
+            cpu->clock_next = now + lapic_tsc_tick;
+        }
+
+        lapic_tsc_deadline_arm(cpu->clock_next);
+    }
+
+    lapic_eoi();
+}
+
+// Local APIC timer clock event device
+clockevent_t lapic_timer_clockevent = {
+    .name         = "Local APIC timer",
+    .vector       = LAPIC_TIMER_INTR,
+    .percpu       = 1,
+    .max_us       = 1000000,
+    .probe        = lapic_timer_probe,
+    .set_periodic = lapic_timer_set_periodic,
+    .set_oneshot  = lapic_timer_set_oneshot,
+    .remaining    = lapic_timer_remaining,
+    .ack          = lapic_eoi
+};
+
+// Local APIC TSC-deadline timer clock event device
+clockevent_t lapic_tsc_deadline_clockevent = {
+    .name         = "Local APIC TSC-deadline timer",
+    .vector       = LAPIC_TIMER_INTR,
+    .percpu       = 1,
+    .max_us       = 1000000,
+    .probe        = lapic_tsc_deadline_probe,
+    .set_periodic = lapic_tsc_deadline_set_periodic,
+    .set_oneshot  = lapic_tsc_deadline_set_oneshot,
+    .remaining    = lapic_tsc_deadline_remaining,
+    .ack          = lapic_tsc_deadline_ack
+};
@@ -0,0 +1,77 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2021
+ *
+ * Local APIC
+ */
+#ifndef LAPIC_H
+#define LAPIC_H
+
+// Local APIC memory mapped register base address
+#define LAPIC_BASE          0xfee00000
+
+// Local APIC registers (offsets from the base address)
+#define LAPIC_ID            0x020   // Local APIC ID
+#define LAPIC_TPR           0x080   // Task priority
+#define LAPIC_EOI           0x0b0   // End of interrupt
+#define LAPIC_SVR           0x0f0   // Spurious interrupt vector
+#define LAPIC_ICR_LOW       0x300   // Interrupt command (low)
+#define LAPIC_ICR_HIGH      0x310   // Interrupt command (high)
+#define LAPIC_LVT_TIMER     0x320   // Local vector table: timer
+#define LAPIC_TIMER_INIT    0x380   // Timer initial count
+#define LAPIC_TIMER_CUR     0x390   // Timer current count
+#define LAPIC_TIMER_DIV     0x3e0   // Timer divide configuration
+
+#ifndef ASSEMBLER
+
+#include "clockevent.h"
+
+/**
+ * Reads the local APIC ID of the executing CPU
+ */
+#define lapic_id() (*(volatile unsigned int *)(LAPIC_BASE + LAPIC_ID) >> 24)
+
+/**
+ * Reads a local APIC register
+ * @param reg - register offset
+ * @return register value
+ */
+unsigned int lapic_read(int reg);
+
+/**
+ * Writes a local APIC register
+ * @param reg - register offset
+ * @param value - value to write
+ */
+void lapic_write(int reg, unsigned int value);
+
+/**
+ * Enables the local APIC of the executing CPU
+ */
+void lapic_init();
+
+/**
+ * Signals the end of the current interrupt to the local APIC
+ */
+void lapic_eoi();
+
+/**
+ * Sends an INIT IPI to all other CPUs
+ */
+void lapic_ipi_init_all();
+
+/**
+ * Sends a STARTUP IPI to all other CPUs
+ * @param vector - page number (address / 4096) where the CPUs start executing
+ */
+void lapic_ipi_startup_all(int vector);
+
+// Local APIC timer clock event device
+extern clockevent_t lapic_timer_clockevent;
+
+// Local APIC TSC-deadline timer clock event device
+extern clockevent_t lapic_tsc_deadline_clockevent;
+
+#endif
+#endif
@@ -10,10 +10,12 @@
 
 #include "mbox.h"
 #include "msg.h"
-#include "queue.h"
 
 mbox_t mailboxes[MBOX_MAX];
 
+// Notification list entries for each process table entry and mailbox
+static mbox_notify_t mbox_notify[PROC_MAX][MBOX_MAX];
+
 /**
  * Initializes mailboxes
  */
@@ -21,10 +23,48 @@ void mbox_init() {
     int i = 0;
     // Initialize mailbox related data structures
     memset(&mailboxes, 0, sizeof(mailboxes));
+    memset(&mbox_notify, 0, sizeof(mbox_notify));
 
-    // Initialize the mutex queue
+    // Initialize the wait lists
     for (i = 0; i < MBOX_MAX; i++)
-        queue_init(&(mailboxes[i].wait_queue));
+        proc_list_init(&(mailboxes[i].wait_list));
+}
+
+/**
+ * Copies bytes to the tail of a mailbox's buffer, wrapping around the end
+ */
+static void mbox_write(mbox_t *box, void *src, int len) {
+    int part = MBOX_DATA_SIZE - box->tail;
+
+    if (part > len) {
+        part = len;
+    }
+
+    memcpy(&box->data[box->tail], src, part);
+    memcpy(&box->data[0], (unsigned char *)src + part, len - part);
+
+    box->tail = (box->tail + len) % MBOX_DATA_SIZE;
+    box->used += len;
+}
+
+/**
+ * Copies bytes from the head of a mailbox's buffer, wrapping around the
+ * end; bytes are skipped if no destination is given
+ */
+static void mbox_read(mbox_t *box, void *dest, int len) {
+    int part = MBOX_DATA_SIZE - box->head;
+
+    if (part > len) {
+        part = len;
+    }
+
+    if (dest) {
+        memcpy(dest, &box->data[box->head], part);
+        memcpy((unsigned char *)dest + part, &box->data[0], len - part);
+    }
+
+    box->head = (box->head + len) % MBOX_DATA_SIZE;
+    box->used -= len;
 }
 
 /**
@@ -35,30 +75,37 @@ void mbox_init() {
  * @return 0 on success, -1 on error
  */
 int mbox_queue_in(int mbox, msg_t *msg) {
+    mbox_t *box;
+    mbox_header_t header;
+
     // Ensure that mailbox is valid
     // Ensure that the message is valid
-    if(msg == NULL) {
+    if(msg == NULL || msg->size < 0 || msg->size > MSG_SIZE) {
         return -1;
     }
 
-    // Return an error if the mailbox is full
-    if(mbox >= MBOX_MAX) {
+    if(mbox < 0 || mbox >= MBOX_MAX) {
         return -1;
     }
 
-    // Copy the message from the passed in pointer to the tail of the mailbox
-    mailboxes[mbox].messages[mailboxes[mbox].tail] = *msg;
-
-    // Move the tail forward
-    mailboxes[mbox].tail++;
+    box = &mailboxes[mbox];
 
-    // If we are at the end of the array, move the tail to the beginning
-    if(mailboxes[mbox].tail >= MBOX_SIZE) {
-        mailboxes[mbox].tail = 0;
+    // Return an error if the mailbox is full
+    if(box->size >= MBOX_SIZE || box->used + (int)sizeof(header) + msg->size > MBOX_DATA_SIZE) {
+        return -1;
     }
 
+    // Copy the header and only the data sent to the tail of the mailbox
+    header.sender = msg->sender;
+    header.time_sent = msg->time_sent;
+    header.size = msg->size;
+    header.buf = msg->buf;
+
+    mbox_write(box, &header, sizeof(header));
+    mbox_write(box, msg->data, msg->size);
+
     // Increment size (since we just added an item to the mailbox)
-    mailboxes[mbox].size++;
+    box->size++;
 
     return 0;
 }
@@ -68,36 +115,164 @@ int mbox_queue_in(int mbox, msg_t *msg) {
  *
  * @param mbox - mailbox number
  * @param msg - pointer to the message data struct to be copied to
+ * @param size - number of bytes of data the message can hold
  * @return 0 on success, -1 on error
  */
-int mbox_queue_out(int mbox, msg_t *msg) {
+int mbox_queue_out(int mbox, msg_t *msg, int size) {
+    mbox_t *box;
+    mbox_header_t header;
+
     // Ensure that mailbox is valid
     // Ensure that the message is valid
-    if(msg == NULL) {
+    if(msg == NULL || size < 0) {
         return -1;
     }
 
     // return an error if mailbox is empty
-    if(mbox >= MBOX_MAX) {
+    if(mbox < 0 || mbox >= MBOX_MAX || mailboxes[mbox].size == 0) {
         return -1;
     }
 
-    // Copy the message from the head of the mailbox to the passed in message pointer
-    *msg = (mailboxes[mbox].messages[mailboxes[mbox].head]);
+    box = &mailboxes[mbox];
 
-    // Clear the memory for the message in the mailbox
-    memset(&(mailboxes[mbox].messages[mailboxes[mbox].head]), 0, sizeof(msg_t));
+    // Copy the message from the head of the mailbox to the passed in message
+    // pointer, dropping any data that does not fit
+    mbox_read(box, &header, sizeof(header));
 
-    // Move the head forward
-    mailboxes[mbox].head++;
-
-    // If we are at the end of the array, move the head to the beginning
-    if(mailboxes[mbox].head >= MBOX_SIZE) {
-        mailboxes[mbox].head = 0;
+    if (size > header.size) {
+        size = header.size;
     }
 
+    msg->sender = header.sender;
+    msg->time_sent = header.time_sent;
+    msg->size = size;
+    msg->buf = header.buf;
+
+    mbox_read(box, msg->data, size);
+    mbox_read(box, NULL, header.size - size);
+
     // Decrement size (since we just removed a message from the mailbox)
-    mailboxes[mbox].size--;
+    box->size--;
 
     return 0;
 }
+
+/**
+ * Copies the header and data of a message
+ *
+ * @param dest - message to copy to
+ * @param src - message to copy (src->size bytes of data)
+ * @param size - number of bytes of data the destination can hold
+ */
+void mbox_msg_copy(msg_t *dest, msg_t *src, int size) {
+    if (size > src->size) {
+        size = src->size;
+    }
+
+    dest->sender = src->sender;
+    dest->time_sent = src->time_sent;
+    dest->time_received = src->time_received;
+    dest->size = size;
+    dest->buf = src->buf;
+
+    memcpy(dest->data, src->data, size);
+}
+
+/**
+ * Adds a process to the notification list of a mailbox
+ *
+ * @param mbox - mailbox number
+ * @param proc - process entry
+ * @return 0 on success, -1 on error
+ */
+int mbox_notify_add(int mbox, proc_t *proc) {
+    mbox_t *box;
+    mbox_notify_t *entry;
+
+    if(mbox < 0 || mbox >= MBOX_MAX || !proc) {
+        return -1;
+    }
+
+    box = &mailboxes[mbox];
+    entry = &mbox_notify[PROC_PID_ENTRY(proc->pid)][mbox];
+
+    // Each process waits on a mailbox at most once
+    if(entry->proc) {
+        return -1;
+    }
+
+    entry->proc = proc;
+    entry->next = NULL;
+    entry->prev = box->notify_tail;
+
+    if(box->notify_tail) {
+        box->notify_tail->next = entry;
+    } else {
+        box->notify_head = entry;
+    }
+
+    box->notify_tail = entry;
+
+    return 0;
+}
+
+/**
+ * Takes the process waiting longest off the notification list of a mailbox
+ *
+ * @param mbox - mailbox number
+ * @return process entry, NULL if no process is waiting
+ */
+proc_t *mbox_notify_pop(int mbox) {
+    proc_t *proc;
+
+    if(mbox < 0 || mbox >= MBOX_MAX || !mailboxes[mbox].notify_head) {
+        return NULL;
+    }
+
+    proc = mailboxes[mbox].notify_head->proc;
+    mbox_notify_cancel(proc);
+
+    return proc;
+}
+
+/**
+ * Takes a process off the notification lists of every mailbox
+ *
+ * @param proc - process entry
+ */
+void mbox_notify_cancel(proc_t *proc) {
+    mbox_t *box;
+    mbox_notify_t *entry;
+    int i;
+
+    if(!proc) {
+        return;
+    }
+
+    for(i = 0; i < MBOX_MAX; i++) {
+        entry = &mbox_notify[PROC_PID_ENTRY(proc->pid)][i];
+
+        if(!entry->proc) {
+            continue;
+        }
+
+        box = &mailboxes[i];
+
+        // Unlink the entry from its neighbors
+        if(entry->prev) {
+            entry->prev->next = entry->next;
+        } else {
+            box->notify_head = entry->next;
+        }
+
+        if(entry->next) {
+            entry->next->prev = entry->prev;
+        } else {
+            box->notify_tail = entry->prev;
+        }
+
+        entry->proc = NULL;
+        entry->next = NULL;
+        entry->prev = NULL;
+    }
+}
@@ -8,18 +8,44 @@
 #ifndef MBOX_H
 #define MBOX_H
 
+#include "kproc.h"
 #include "msg.h"
-#include "queue.h"
 
 #define MBOX_MAX 10     // Maximum number of mailboxes supported
 #define MBOX_SIZE 64    // Maximum number of messages possible in each mailbox
 
+// Header stored ahead of the data of each queued message
 typedef struct {
-    msg_t messages[MBOX_SIZE];      // Messages
-    int head;                       // First message
-    int tail;                       // Last message
+    int sender;                     // Process ID that sent the message
+    int time_sent;                  // Time that message was sent
+    int size;                       // Number of bytes of data
+    int buf;                        // Message buffer passed along (0 if none)
+} mbox_header_t;
+
+// Bytes of messages each mailbox holds (enough for MBOX_SIZE messages of
+// MSG_SIZE bytes each)
+#define MBOX_DATA_SIZE (MBOX_SIZE * (int)(sizeof(mbox_header_t) + MSG_SIZE))
+
+// Entry linking a process waiting in msg_select() into the notification
+// list of one of the mailboxes it waits on
+typedef struct mbox_notify_t {
+    struct proc_t *proc;            // Waiting process (NULL if not linked)
+    struct mbox_notify_t *next;     // Next entry in the mailbox's list
+    struct mbox_notify_t *prev;     // Previous entry in the mailbox's list
+} mbox_notify_t;
+
+// Messages are stored back to back in a circular buffer: a header (the
+// sender, time sent, size and message buffer) followed by only the bytes
+// of data sent
+typedef struct {
+    unsigned char data[MBOX_DATA_SIZE]; // Messages
+    int head;                       // Offset of the first message
+    int tail;                       // Offset following the last message
+    int used;                       // Bytes of the buffer in use
     int size;                       // Size of the message queue
-    queue_t wait_queue;             // Processes waiting for messages
+    proc_list_t wait_list;          // Processes waiting for messages
+    mbox_notify_t *notify_head;     // Processes waiting for the mailbox to
+    mbox_notify_t *notify_tail;     // have a message (see msg_select())
 } mbox_t;
 
 /**
@@ -29,6 +55,7 @@ void mbox_init();
 
 /**
  * Queues a message into the given mailbox
+ * Only the header and msg->size bytes of data are stored.
  *
  * @param mbox - mailbox number
  * @param msg - pointer to the message from the calling process
@@ -38,11 +65,48 @@ int mbox_queue_in(int mbox, msg_t *msg);
 
 /**
  * De-queues a message out of the given mailbox
+ * Data beyond the given size is discarded; msg->size is set to the number
+ * of bytes received.
  *
  * @param mbox - mailbox number
  * @param msg - pointer to the message from the calling process
+ * @param size - number of bytes of data the message can hold
  * @return 0 on success, -1 on error
  */
-int mbox_queue_out(int mbox, msg_t *msg);
+int mbox_queue_out(int mbox, msg_t *msg, int size);
+
+/**
+ * Copies the header and data of a message
+ *
+ * @param dest - message to copy to
+ * @param src - message to copy (src->size bytes of data)
+ * @param size - number of bytes of data the destination can hold
+ */
+void mbox_msg_copy(msg_t *dest, msg_t *src, int size);
+
+/**
+ * Adds a process to the notification list of a mailbox
+ *
+ * @param mbox - mailbox number
+ * @param proc - process entry
+ * @return 0 on success, -1 on error
+ */
+int mbox_notify_add(int mbox, proc_t *proc);
+
+/**
+ * Takes the process waiting longest off the notification list of a mailbox
+ * The process is also taken off the lists of the other mailboxes it waits on.
+ *
+ * @param mbox - mailbox number
+ * @return process entry, NULL if no process is waiting
+ */
+proc_t *mbox_notify_pop(int mbox);
+
+/**
+ * Takes a process off the notification lists of every mailbox
+ *
+ * @param proc - process entry
+ */
+void mbox_notify_cancel(proc_t *proc);
 
 #endif
@@ -14,6 +14,8 @@ typedef struct msg_t {
     int sender;                     // Process ID that sent the message
     int time_sent;                  // Time that message was sent
     int time_received;              // Time that message was received
+    int size;                       // Number of bytes of data
+    int buf;                        // Message buffer passed along (0 if none)
     unsigned char data[MSG_SIZE];   // Message data
 } msg_t;
 
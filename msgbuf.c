@@ -0,0 +1,234 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2021
+ *
+ * Message buffers shared between processes
+ *
+ * Large payloads are written once into a buffer from the pool and passed
+ * between processes by handle; sending a message with a buffer moves a
+ * reference to it rather than copying its contents.
+ */
+
+#include <spede/string.h>
+
+#include "kproc.h"
+#include "kutil.h"
+#include "msgbuf.h"
+#include "queue.h"
+
+// Message buffer
+typedef struct {
+    int gen;                        // Generation (advanced each time it is freed)
+    int size;                       // Size in bytes (0 if free)
+    int refs;                       // References held by processes and by
+                                    // messages that have not been received
+} msgbuf_t;
+
+// Message buffers
+static msgbuf_t msgbufs[MSGBUF_MAX];
+
+// Message buffer contents
+static unsigned char msgbuf_data[MSGBUF_MAX][MSGBUF_SIZE] __attribute__((aligned(16)));
+
+// Available message buffers
+static queue_t msgbuf_queue;
+
+/**
+ * Looks up a message buffer the process holds a reference to
+ * @return buffer index, -1 if the handle is invalid or not held
+ */
+static int msgbuf_lookup(proc_t *proc, int buf) {
+    int index;
+
+    if (buf <= 0) {
+        return -1;
+    }
+
+    index = MSGBUF_INDEX(buf);
+
+    if (msgbufs[index].size == 0 || MSGBUF_HANDLE(index, msgbufs[index].gen) != buf) {
+        return -1;
+    }
+
+    if (proc && proc->msgbuf_refs[index] == 0) {
+        return -1;
+    }
+
+    return index;
+}
+
+/**
+ * Drops a reference to a message buffer, freeing it with the last one
+ */
+static void msgbuf_put(int index) {
+    if (--msgbufs[index].refs > 0) {
+        return;
+    }
+
+    msgbufs[index].size = 0;
+    msgbufs[index].gen++;
+
+    if (queue_in(&msgbuf_queue, index) != 0) {
+        panic("Unable to free message buffer %d", index);
+    }
+}
+
+/**
+ * Initializes the message buffer pool
+ */
+void msgbuf_init() {
+    int i;
+
+    memset(msgbufs, 0, sizeof(msgbufs));
+    queue_init(&msgbuf_queue);
+
+    for (i = 0; i < MSGBUF_MAX; i++) {
+        // Handles start at generation 1 so that 0 is never a valid handle
+        msgbufs[i].gen = 1;
+
+        if (queue_in(&msgbuf_queue, i) != 0) {
+            panic("Unable to initialize message buffer queue for buffer %d", i);
+        }
+    }
+}
+
+/**
+ * Allocates a message buffer
+ * @param proc - process entry
+ * @param size - size of the buffer in bytes
+ * @param data - set to the address of the buffer
+ * @return buffer handle, -1 on error
+ */
+int msgbuf_alloc(proc_t *proc, int size, void **data) {
+    int index;
+
+    if (!proc || !data || size <= 0 || size > MSGBUF_SIZE) {
+        return -1;
+    }
+
+    if (queue_out(&msgbuf_queue, &index) != 0) {
+        return -1;
+    }
+
+    msgbufs[index].size = size;
+    msgbufs[index].refs = 1;
+    proc->msgbuf_refs[index] = 1;
+
+    *data = msgbuf_data[index];
+
+    return MSGBUF_HANDLE(index, msgbufs[index].gen);
+}
+
+/**
+ * Looks up a message buffer the process holds a reference to
+ * @param proc - process entry
+ * @param buf - buffer handle
+ * @param data - set to the address of the buffer
+ * @return size of the buffer in bytes, -1 on error
+ */
+int msgbuf_map(proc_t *proc, int buf, void **data) {
+    int index = msgbuf_lookup(proc, buf);
+
+    if (index < 0 || !data) {
+        return -1;
+    }
+
+    *data = msgbuf_data[index];
+
+    return msgbufs[index].size;
+}
+
+/**
+ * Adds a reference to a message buffer the process holds a reference to
+ * @param proc - process entry
+ * @param buf - buffer handle
+ * @return 0 on success, -1 on error
+ */
+int msgbuf_dup(proc_t *proc, int buf) {
+    int index = msgbuf_lookup(proc, buf);
+
+    if (index < 0 || proc->msgbuf_refs[index] == 0xff) {
+        return -1;
+    }
+
+    proc->msgbuf_refs[index]++;
+    msgbufs[index].refs++;
+
+    return 0;
+}
+
+/**
+ * Releases a reference the process holds to a message buffer
+ * @param proc - process entry
+ * @param buf - buffer handle
+ * @return 0 on success, -1 on error
+ */
+int msgbuf_release(proc_t *proc, int buf) {
+    int index = msgbuf_lookup(proc, buf);
+
+    if (index < 0) {
+        return -1;
+    }
+
+    proc->msgbuf_refs[index]--;
+    msgbuf_put(index);
+
+    return 0;
+}
+
+/**
+ * Moves a reference held by the process to a message being sent
+ * @param proc - process entry
+ * @param buf - buffer handle
+ * @return 0 on success, -1 if the process does not hold a reference
+ */
+int msgbuf_send(proc_t *proc, int buf) {
+    int index = msgbuf_lookup(proc, buf);
+
+    if (index < 0) {
+        return -1;
+    }
+
+    // The buffer's reference count is unchanged; the message now holds it
+    proc->msgbuf_refs[index]--;
+
+    return 0;
+}
+
+/**
+ * Moves the reference of a received message to the receiving process
+ * @param proc - process entry
+ * @param buf - buffer handle
+ */
+void msgbuf_receive(proc_t *proc, int buf) {
+    int index = msgbuf_lookup(NULL, buf);
+
+    if (index < 0) {
+        panic_warn("Received an invalid message buffer");
+        return;
+    }
+
+    // A process holding as many references as it can gives the extra one up
+    if (proc->msgbuf_refs[index] == 0xff) {
+        msgbuf_put(index);
+        return;
+    }
+
+    proc->msgbuf_refs[index]++;
+}
+
+/**
+ * Releases all references held by a process that is exiting
+ * @param proc - process entry
+ */
+void msgbuf_proc_exit(proc_t *proc) {
+    int i;
+
+    for (i = 0; i < MSGBUF_MAX; i++) {
+        while (proc->msgbuf_refs[i] > 0) {
+            proc->msgbuf_refs[i]--;
+            msgbuf_put(i);
+        }
+    }
+}
@@ -0,0 +1,84 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2021
+ *
+ * Message buffers shared between processes
+ */
+#ifndef MSGBUF_H
+#define MSGBUF_H
+
+struct proc_t;
+
+#define MSGBUF_MAX 16       // Number of message buffers
+#define MSGBUF_SIZE 4096    // Maximum size of a message buffer
+
+// Message buffers are referred to by handles that encode the buffer along
+// with a generation count so stale handles can be detected (never 0)
+#define MSGBUF_HANDLE(index, gen)   ((gen) * MSGBUF_MAX + (index))
+#define MSGBUF_INDEX(handle)        ((handle) % MSGBUF_MAX)
+
+/**
+ * Initializes the message buffer pool
+ */
+void msgbuf_init();
+
+/**
+ * Allocates a message buffer
+ * The process holds the only reference to the buffer.
+ * @param proc - process entry
+ * @param size - size of the buffer in bytes
+ * @param data - set to the address of the buffer
+ * @return buffer handle, -1 on error
+ */
+int msgbuf_alloc(struct proc_t *proc, int size, void **data);
+
+/**
+ * Looks up a message buffer the process holds a reference to
+ * @param proc - process entry
+ * @param buf - buffer handle
+ * @param data - set to the address of the buffer
+ * @return size of the buffer in bytes, -1 on error
+ */
+int msgbuf_map(struct proc_t *proc, int buf, void **data);
+
+/**
+ * Adds a reference to a message buffer the process holds a reference to
+ * (so it can be sent more than once)
+ * @param proc - process entry
+ * @param buf - buffer handle
+ * @return 0 on success, -1 on error
+ */
+int msgbuf_dup(struct proc_t *proc, int buf);
+
+/**
+ * Releases a reference the process holds to a message buffer
+ * The buffer is freed once its last reference is released.
+ * @param proc - process entry
+ * @param buf - buffer handle
+ * @return 0 on success, -1 on error
+ */
+int msgbuf_release(struct proc_t *proc, int buf);
+
+/**
+ * Moves a reference held by the process to a message being sent
+ * @param proc - process entry
+ * @param buf - buffer handle
+ * @return 0 on success, -1 if the process does not hold a reference
+ */
+int msgbuf_send(struct proc_t *proc, int buf);
+
+/**
+ * Moves the reference of a received message to the receiving process
+ * @param proc - process entry
+ * @param buf - buffer handle
+ */
+void msgbuf_receive(struct proc_t *proc, int buf);
+
+/**
+ * Releases all references held by a process that is exiting
+ * @param proc - process entry
+ */
+void msgbuf_proc_exit(struct proc_t *proc);
+
+#endif
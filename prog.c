@@ -52,6 +52,9 @@ void prog_forever_sleep() {
  * Test "program" that will just "delay" over and over forever
  */
 void prog_forever_delay() {
+    // Batch work; let interactive processes run ahead of it
+    proc_set_priority(proc_get_pid(), PROC_PRIORITY_LOW);
+
     // Delay for 10s forever and ever
     while(1) {
         delay(10);
@@ -212,6 +215,7 @@ void prog_test() {
 void prog_producer() {
     msg_t msg;
     struct test_data test_data;
+    syscall_batch_t batch[2];
 
     int pid = proc_get_pid();
     int mbox = pid % 2;
@@ -219,6 +223,7 @@ void prog_producer() {
     int start_time = sys_get_time();
 
     memset(&test_data, 0, sizeof(struct test_data));
+    memset(batch, 0, sizeof(batch));
 
     while (current_time - start_time <= ((pid * 2) % 15) && test_data.sequence != WORD_COUNT) {
         current_time = sys_get_time();
@@ -228,12 +233,19 @@ void prog_producer() {
 
         test_data.sequence++;
 
-        if (msg_send(mbox, &msg) != 0) {
+        // Send the message and sleep with a single kernel entry
+        batch[0].syscall = SYSCALL_MSG_SEND_SIZE;
+        batch[0].args[0] = mbox;
+        batch[0].args[1] = (unsigned int)&msg;
+        batch[0].args[2] = sizeof(struct test_data);
+        batch[0].flags = SYSCALL_BATCH_STOP_ON_ERROR;
+        batch[1].syscall = SYSCALL_SLEEP;
+        batch[1].args[0] = 1;
+
+        if (sys_batch(batch, 2) < 1 || batch[0].rc != 0) {
             cons_printf("pid=%d: Unable to send message... exiting\n", pid);
             proc_exit();
         }
-
-        sleep(1);
     }
 
     proc_exit();
@@ -242,6 +254,8 @@ void prog_producer() {
 void prog_consumer() {
     msg_t msg;
     struct test_data test_data;
+    char buf[BUF_LEN];
+    int len;
 
     int pid = proc_get_pid();
     int mbox = pid % 2;
@@ -251,7 +265,7 @@ void prog_consumer() {
     memset(&test_data, 0, sizeof(struct test_data));
 
     while (current_time - start_time <= ((pid * 2) % 15)) {
-        if (msg_recv(mbox, &msg) != 0) {
+        if (msg_recv_size(mbox, &msg, sizeof(struct test_data)) != 0) {
             cons_printf("pid=%d: Unable to receive message... exiting\n", pid);
             proc_exit();
         }
@@ -260,11 +274,16 @@ void prog_consumer() {
 
         memcpy(&test_data, (struct test_data *)&msg.data, sizeof(struct test_data));
 
-        cons_printf("%04d (pid=%d) Received msg (sender=%d, sent=%d, recv=%d)\n",
-                    current_time, pid, msg.sender, msg.time_sent, msg.time_received);
+        // Log through the buffered serial console so receiving is not held
+        // up by the screen
+        len = snprintf(buf, BUF_LEN, "%04d (pid=%d) Received msg (sender=%d, sent=%d, recv=%d)\n"
+                       "\t\tdata (sequence=%d, word='%s')\n",
+                       current_time, pid, msg.sender, msg.time_sent, msg.time_received,
+                       test_data.sequence, test_data.word);
 
-        cons_printf("\t\tdata (sequence=%d, word='%s')\n",
-                    test_data.sequence, test_data.word);
+        if (len > 0) {
+            sys_write(buf, len < BUF_LEN ? len : BUF_LEN - 1);
+        }
     }
 
     proc_exit();
@@ -16,35 +16,520 @@
 
 #include "queue.h"
 
+/**
+ * Sleeping processes
+ * Binary min-heap ordered by wake time (1-based; entry 0 is unused) so the
+ * scheduler only needs to look at the earliest sleeper on each run
+ */
+proc_t *sleep_queue[PROC_MAX + 1];
+int sleep_count;
+
+// System time when processes will next be boosted to their base priority
+int boost_time;
+
+// Number of real-time deadlines missed
+int sched_rt_misses;
+
+/**
+ * Places a process at the given sleep queue position
+ */
+static void sleep_queue_set(int pos, proc_t *proc) {
+    sleep_queue[pos] = proc;
+    proc->sleep_pos = pos;
+}
+
+/**
+ * Moves the process at the given position towards the head of the sleep
+ * queue until the heap is ordered again
+ */
+static void sleep_queue_up(int pos) {
+    proc_t *proc = sleep_queue[pos];
+
+    while (pos > 1 && sleep_queue[pos / 2]->wake_time > proc->wake_time) {
+        sleep_queue_set(pos, sleep_queue[pos / 2]);
+        pos /= 2;
+    }
+
+    sleep_queue_set(pos, proc);
+}
+
+/**
+ * Moves the process at the given position towards the tail of the sleep
+ * queue until the heap is ordered again
+ */
+static void sleep_queue_down(int pos) {
+    proc_t *proc = sleep_queue[pos];
+    int child;
+
+    while ((child = pos * 2) <= sleep_count) {
+        // Select the child that wakes up first
+        if (child < sleep_count &&
+            sleep_queue[child + 1]->wake_time < sleep_queue[child]->wake_time) {
+            child++;
+        }
+
+        if (proc->wake_time <= sleep_queue[child]->wake_time) {
+            break;
+        }
+
+        sleep_queue_set(pos, sleep_queue[child]);
+        pos = child;
+    }
+
+    sleep_queue_set(pos, proc);
+}
+
+/**
+ * Removes a process from the sleep queue
+ */
+static void sleep_queue_remove(proc_t *proc) {
+    proc_t *last;
+    int pos = proc->sleep_pos;
+
+    if (pos == 0) {
+        return;
+    }
+
+    proc->sleep_pos = 0;
+
+    // Take the last entry off of the heap
+    last = sleep_queue[sleep_count];
+    sleep_queue[sleep_count] = NULL;
+    sleep_count--;
+
+    // Fill the hole with the last entry and restore the heap order
+    if (last != proc) {
+        sleep_queue_set(pos, last);
+        sleep_queue_up(pos);
+        sleep_queue_down(last->sleep_pos);
+    }
+}
+
+// Scheduling ranks; a process with a lower rank is run first, except that
+// stride and MLFQ processes take turns in proportion to their tickets
+#define SCHED_RANK_EDF      0                   // Real-time processes
+#define SCHED_RANK_STRIDE   1                   // Stride scheduled processes
+#define SCHED_RANK_MLFQ     2                   // First feedback queue level
+#define SCHED_RANK_NONE     (SCHED_RANK_MLFQ + SCHED_LEVELS)
+
+/**
+ * Compares stride scheduling passes (allowing for wrap around)
+ * @return non-zero if pass a comes before pass b
+ */
+#define stride_before(a, b) ((int)((unsigned int)(a) - (unsigned int)(b)) < 0)
+
+/**
+ * Determines if a process is held in one of the run queues of its CPU
+ */
+static int scheduler_queued(proc_t *proc) {
+    cpu_t *cpu = &cpus[proc->cpu];
+
+    if (proc->list == &cpu->edf_queue || proc->list == &cpu->stride_queue) {
+        return 1;
+    }
+
+    return proc->list >= &cpu->run_queue[0] && proc->list < &cpu->run_queue[SCHED_LEVELS];
+}
+
+/**
+ * Returns the scheduling rank of a process
+ */
+static int scheduler_rank(proc_t *proc) {
+    if (proc->rt_period > 0) {
+        return SCHED_RANK_EDF;
+    }
+
+    if (proc->tickets > 0) {
+        return SCHED_RANK_STRIDE;
+    }
+
+    return SCHED_RANK_MLFQ + proc->level;
+}
+
+/**
+ * Returns the stride pass of the MLFQ processes of a CPU
+ * Like a stride process, they do not keep credit built up while none of
+ * them were runnable.
+ */
+static int scheduler_mlfq_pass(cpu_t *cpu) {
+    if (stride_before(cpu->mlfq_pass, cpu->stride_pass)) {
+        return cpu->stride_pass;
+    }
+
+    return cpu->mlfq_pass;
+}
+
+/**
+ * Finds the rank of the most important process waiting on a CPU
+ * @param first - most important rank to consider
+ * @return scheduling rank, SCHED_RANK_NONE if all run queues are empty
+ */
+static int scheduler_top_rank(cpu_t *cpu, int first) {
+    int level;
+
+    if (first <= SCHED_RANK_EDF && cpu->edf_queue.size > 0) {
+        return SCHED_RANK_EDF;
+    }
+
+    for (level = 0; level < SCHED_LEVELS; level++) {
+        if (cpu->run_queue[level].size > 0) {
+            break;
+        }
+    }
+
+    // The MLFQ processes run in place of the stride queue when their
+    // combined pass comes first
+    if (first <= SCHED_RANK_STRIDE && cpu->stride_queue.size > 0 &&
+        (level == SCHED_LEVELS ||
+         !stride_before(scheduler_mlfq_pass(cpu), cpu->stride_queue.head->pass))) {
+        return SCHED_RANK_STRIDE;
+    }
+
+    return level < SCHED_LEVELS ? SCHED_RANK_MLFQ + level : SCHED_RANK_NONE;
+}
+
+/**
+ * Removes the most important waiting process from the run queues of a CPU
+ * @param first - most important rank to consider
+ * @return pointer to the process entry, NULL if no processes are waiting
+ */
+static proc_t *scheduler_pop(cpu_t *cpu, int first) {
+    proc_t *proc;
+    int rank = scheduler_top_rank(cpu, first);
+
+    if (rank == SCHED_RANK_NONE) {
+        return NULL;
+    }
+
+    if (rank == SCHED_RANK_EDF) {
+        // The EDF queue is ordered by deadline; the head is due first
+        return proc_list_pop(&cpu->edf_queue);
+    }
+
+    if (rank == SCHED_RANK_STRIDE) {
+        // The stride queue is ordered by pass; the head has the lowest
+        proc = proc_list_pop(&cpu->stride_queue);
+        cpu->stride_pass = proc->pass;
+        return proc;
+    }
+
+    cpu->mlfq_pass = scheduler_mlfq_pass(cpu);
+    cpu->stride_pass = cpu->mlfq_pass;
+
+    return proc_list_pop(&cpu->run_queue[rank - SCHED_RANK_MLFQ]);
+}
+
+/**
+ * Adds a stride scheduled process to the stride queue of its CPU, ordered
+ * by pass
+ */
+static void scheduler_stride_add(proc_t *proc) {
+    cpu_t *cpu = &cpus[proc->cpu];
+    proc_t *next;
+
+    // A process does not keep credit built up while it was not runnable,
+    // otherwise it could monopolize the CPU after sleeping
+    if (stride_before(proc->pass, cpu->stride_pass)) {
+        proc->pass = cpu->stride_pass;
+    }
+
+    for (next = cpu->stride_queue.head; next; next = next->next) {
+        if (stride_before(proc->pass, next->pass)) {
+            break;
+        }
+    }
+
+    if (proc_list_insert(&cpu->stride_queue, next, proc) != 0) {
+        panic("Unable to add the process to the scheduler");
+    }
+}
+
+/**
+ * Brings the real-time job of a process up to date
+ * A job that still has budget left at its deadline is counted as a missed
+ * deadline. A new job (with a fresh budget and deadline) is released once
+ * the period of the previous release has passed. A job keeps its remaining
+ * budget while its process is blocked, so a process woken before the
+ * deadline (such as when handed a mutex) carries on with the same job.
+ */
+static void scheduler_rt_update(proc_t *proc) {
+    if (proc->rt_remaining > 0 && system_time >= proc->rt_deadline) {
+        proc->rt_misses++;
+        sched_rt_misses++;
+        proc->rt_remaining = 0;
+    }
+
+    if (system_time >= proc->rt_release) {
+        proc->rt_remaining = proc->rt_budget;
+        proc->rt_deadline  = system_time + proc->rt_rel_deadline;
+        proc->rt_release   = system_time + proc->rt_period;
+    }
+}
+
+/**
+ * Adds a real-time process to the EDF queue of its CPU, ordered by deadline
+ * Processes that have used up the budget of their current job are held in
+ * the sleep queue until their next job is released.
+ * @return 0 if the process was queued, -1 if it was throttled
+ */
+static int scheduler_edf_add(proc_t *proc) {
+    cpu_t *cpu = &cpus[proc->cpu];
+    proc_t *next;
+
+    scheduler_rt_update(proc);
+
+    if (proc->rt_remaining <= 0) {
+        scheduler_sleep(proc, proc->rt_release);
+        return -1;
+    }
+
+    for (next = cpu->edf_queue.head; next; next = next->next) {
+        if (proc->rt_deadline < next->rt_deadline) {
+            break;
+        }
+    }
+
+    if (proc_list_insert(&cpu->edf_queue, next, proc) != 0) {
+        panic("Unable to add the process to the scheduler");
+    }
+
+    return 0;
+}
+
+/**
+ * Counts the processes waiting in the run queues of a CPU
+ * Real-time processes are held by the CPU they were admitted on, so they
+ * are not counted
+ */
+static int scheduler_load(cpu_t *cpu) {
+    int level;
+    int load = cpu->stride_queue.size;
+
+    for (level = 0; level < SCHED_LEVELS; level++) {
+        load += cpu->run_queue[level].size;
+    }
+
+    return load;
+}
+
+/**
+ * Takes the highest priority waiting process from the busiest other CPU
+ * and moves it to the given CPU
+ * @return 0 if a process was moved, -1 if no other CPU has waiting processes
+ */
+static int scheduler_steal(cpu_t *cpu) {
+    cpu_t *victim = NULL;
+    proc_t *proc;
+    int rank;
+    int load;
+    int max_load = 0;
+    int i;
+
+    for (i = 0; i < cpu_count; i++) {
+        if (&cpus[i] == cpu) {
+            continue;
+        }
+
+        load = scheduler_load(&cpus[i]);
+
+        if (load > max_load) {
+            max_load = load;
+            victim = &cpus[i];
+        }
+    }
+
+    if (!victim) {
+        return -1;
+    }
+
+    // Unlink the process directly rather than through scheduler_pop() so
+    // the passes of the victim are left as they are; its remaining stride
+    // and MLFQ processes did not get to run
+    rank = scheduler_top_rank(victim, SCHED_RANK_STRIDE);
+
+    if (rank == SCHED_RANK_STRIDE) {
+        proc = proc_list_pop(&victim->stride_queue);
+    } else {
+        proc = proc_list_pop(&victim->run_queue[rank - SCHED_RANK_MLFQ]);
+    }
+
+    proc->cpu = cpu->id;
+    scheduler_add(proc);
+
+    return 0;
+}
+
+/**
+ * Returns the time slice (in ticks) of a process
+ */
+static int scheduler_timeslice(proc_t *proc) {
+    int ticks = proc->timeslice > 0 ? proc->timeslice : PROC_TIMESLICE;
+
+    if (proc->tickets > 0) {
+        return ticks;
+    }
+
+    return ticks << proc->level;
+}
+
+/**
+ * Adapts the time slice of a process after it stops running
+ * Processes that keep using their entire time slice get a longer one so
+ * they are switched less often; processes that block early get a shorter
+ * one so they wait less behind others when they become ready again
+ * @param expired - non-zero if the process used its entire time slice
+ */
+static void scheduler_adapt_timeslice(proc_t *proc, int expired) {
+    int ticks;
+
+    if (!proc->timeslice_adaptive) {
+        return;
+    }
+
+    ticks = proc->timeslice > 0 ? proc->timeslice : PROC_TIMESLICE;
+
+    if (expired) {
+        ticks = ticks * 2;
+    } else if (proc->active_time < scheduler_timeslice(proc)) {
+        ticks = ticks / 2;
+    }
+
+    if (ticks < PROC_TIMESLICE_MIN) {
+        ticks = PROC_TIMESLICE_MIN;
+    } else if (ticks > PROC_TIMESLICE_MAX) {
+        ticks = PROC_TIMESLICE_MAX;
+    }
+
+    proc->timeslice = ticks;
+}
+
+/**
+ * Moves a process to the given scheduling level
+ */
+static void scheduler_set_level(proc_t *proc, int level) {
+    proc->level = level;
+    proc->level_start = proc->cpu_time;
+
+    // Move scheduled processes into the run queue for the new level
+    if (scheduler_queued(proc)) {
+        scheduler_add(proc);
+    }
+}
+
+/**
+ * Moves every process back to the scheduling level of its base priority
+ * so that processes demoted by CPU usage cannot be starved
+ */
+static void scheduler_boost() {
+    int i;
+    proc_t *proc;
+
+    for (i = 0; i < PROC_MAX; i++) {
+        proc = &proc_table[i];
+
+        if (proc->state != NONE) {
+            scheduler_set_level(proc, proc->priority);
+        }
+    }
+}
+
 /**
  * Initialize the scheduler
  */
 void scheduler_init() {
-    queue_init(&run_queue);
+    int i;
+    int level;
+
+    for (i = 0; i < CPU_MAX; i++) {
+        for (level = 0; level < SCHED_LEVELS; level++) {
+            proc_list_init(&cpus[i].run_queue[level]);
+        }
+
+        proc_list_init(&cpus[i].stride_queue);
+        cpus[i].stride_pass = 0;
+        cpus[i].mlfq_pass = 0;
+
+        proc_list_init(&cpus[i].edf_queue);
+        cpus[i].rt_util = 0;
+    }
+
+    memset(sleep_queue, 0, sizeof(sleep_queue));
+    sleep_count = 0;
+
+    boost_time = system_time + SCHED_BOOST_PERIOD;
+
+    sched_rt_misses = 0;
 }
 
 /**
  * Process scheduler
+ * Real-time processes run first, earliest deadline first, for up to their
+ * budget in each period.
+ * Processes with stride scheduling tickets run next, always selecting the
+ * process with the lowest pass so that CPU time is shared in proportion
+ * to the tickets held. The feedback queue takes part with a pass of its
+ * own, charged for every tick its processes run.
+ * All other processes use a multi-level feedback queue: processes are
+ * selected from the highest priority run queue, demoted one level each
+ * time they use their entire time slice and periodically boosted back to
+ * their base priority.
+ * Each CPU schedules from its own run queues and takes work from the
+ * busiest CPU when its own run queues are empty.
  */
 void scheduler_run() {
-    int i;
-    int pid;
-
+    cpu_t *cpu = cpu_this();
     proc_t *proc;
+    int rank;
 
     // Ensure that processes not in the active state aren't still scheduled
     if (current && current->state != ACTIVE) {
         current = NULL;
     }
 
+    // Re-queue real-time processes whose deadline passed while waiting so
+    // the miss is counted and their next job is released
+    while (cpu->edf_queue.size > 0 && cpu->edf_queue.head->rt_deadline <= system_time) {
+        scheduler_add(cpu->edf_queue.head);
+    }
+
+    // Periodically boost all processes back to their base priority
+    if (system_time >= boost_time) {
+        scheduler_boost();
+        boost_time = system_time + SCHED_BOOST_PERIOD;
+    }
+
     // Check if we have a current/active process
-    if (current) {
+    if (current && current->rt_period > 0) {
+        // Real-time processes run until their job uses up its budget or
+        // reaches its deadline
+        if (current->rt_remaining <= 0 || system_time >= current->rt_deadline) {
+            current->active_time = 0;
+            scheduler_add(current);
+            current = NULL;
+        }
+    } else if (current) {
         // Check if the current process has exceeded it's time slice
-        if (current->active_time >= PROC_TIMESLICE) {
+        // Time used at the current level accumulates across time slices so
+        // a process cannot avoid demotion by giving up the CPU early
+        if (current->active_time >= scheduler_timeslice(current) ||
+            (current->tickets == 0 &&
+             current->cpu_time - current->level_start >= scheduler_timeslice(current))) {
             // Reset the active time
             current->active_time = 0;
 
-            if (current->pid != 0) {
+            if (!proc_is_idle(current)) {
+                scheduler_adapt_timeslice(current, 1);
+
+                // Demote the process since it used its entire time slice
+                // (stride processes are charged through their pass instead)
+                if (current->tickets == 0) {
+                    if (current->level < SCHED_LEVELS - 1) {
+                        scheduler_set_level(current, current->level + 1);
+                    } else {
+                        current->level_start = current->cpu_time;
+                    }
+                }
+
                 // Add the process to the scheuler
                 scheduler_add(current);
             } else {
@@ -57,36 +542,76 @@ void scheduler_run() {
     }
 
     // Check if we have any processes that need to wake up
-    for (i = 0; i < PROC_MAX; i++) {
-        // Local pointer
-        proc = &proc_table[i];
+    // Only the head of the sleep queue needs to be checked since it will
+    // always be the process with the earliest wake time
+    while (sleep_count > 0 && sleep_queue[1]->wake_time <= system_time) {
+        proc = sleep_queue[1];
+        sleep_queue_remove(proc);
 
-        // Is the process sleeping?
-        if (proc->state == SLEEPING) {
-            // Is the process ready to wake up yet?
-            if (proc->wake_time <= system_time) {
-                // Clear the wake time, active time and add the process to the scheduler
-                proc->active_time = 0;
-                proc->wake_time = 0;
-                scheduler_add(proc);
-            }
+        // A process waiting with a timeout gives up waiting
+        if (proc->list) {
+            proc_list_remove(proc);
+        }
+
+        // Clear the wake time, active time and add the process to the scheduler
+        proc->active_time = 0;
+        proc->wake_time = 0;
+        scheduler_add(proc);
+    }
+
+    rank = scheduler_top_rank(cpu, SCHED_RANK_EDF);
+
+    // Look for work on other CPUs if there is nothing else to run
+    if (rank == SCHED_RANK_NONE && (!current || proc_is_idle(current))) {
+        if (scheduler_steal(cpu) == 0) {
+            rank = scheduler_top_rank(cpu, SCHED_RANK_EDF);
+        }
+    }
+
+    // Stride and MLFQ processes take turns at the end of each time slice,
+    // so a running MLFQ process is only preempted by a higher MLFQ level
+    if (rank == SCHED_RANK_STRIDE && current && !proc_is_idle(current) &&
+        scheduler_rank(current) >= SCHED_RANK_MLFQ) {
+        rank = scheduler_top_rank(cpu, SCHED_RANK_MLFQ);
+    }
+
+    // Preempt the current process if a higher priority process is ready
+    // The idle task is preempted by any ready process
+    if (current && rank != SCHED_RANK_NONE) {
+        if (proc_is_idle(current)) {
+            current->active_time = 0;
+            current->state = RUNNING;
+            current = NULL;
+        } else if (rank < scheduler_rank(current) ||
+                   (rank == SCHED_RANK_EDF && current->rt_period > 0 &&
+                    cpu->edf_queue.head->rt_deadline < current->rt_deadline)) {
+            // The process keeps its active time for when it runs again
+            scheduler_add(current);
+            current = NULL;
+        }
+    }
+
+    // Run the process the previous process gave the CPU to, unless a more
+    // important process is waiting
+    if (!current && cpu->donate) {
+        proc = cpu->donate;
+        cpu->donate = NULL;
+
+        if (proc->state == RUNNING && proc->cpu == cpu->id && scheduler_queued(proc) &&
+            scheduler_rank(proc) <= scheduler_top_rank(cpu, SCHED_RANK_EDF)) {
+            proc_list_remove(proc);
+            current = proc;
         }
     }
 
     // Check if we have a process scheduled or not
     if (!current) {
-        // Get the proces id from the run queue
-        if (queue_out(&run_queue, &pid) != 0) {
-            // default to process id 0 (idle task)
-            pid = 0;
-        }
+        // Get the most important process from the run queues
+        current = scheduler_pop(cpu, SCHED_RANK_EDF);
 
-        // Look up the process for the given process id
-        for (i = 0; i < PROC_MAX; i++) {
-            if (proc_table[i].pid == pid) {
-                current = &proc_table[i];
-                break;
-            }
+        // default to the idle task of this CPU
+        if (!current) {
+            current = cpu->idle;
         }
     }
 
@@ -104,34 +629,238 @@ void scheduler_add(proc_t *proc) {
         panic("Invalid process!");
     }
 
-    if (queue_in(&run_queue, proc->pid) != 0) {
+    // Re-queue the process if it is already scheduled
+    if (scheduler_queued(proc)) {
+        proc_list_remove(proc);
+    }
+
+    if (proc->rt_period > 0) {
+        if (scheduler_edf_add(proc) != 0) {
+            return;
+        }
+    } else if (proc->tickets > 0) {
+        scheduler_stride_add(proc);
+    } else if (proc_list_push(&cpus[proc->cpu].run_queue[proc->level], proc) != 0) {
         panic("Unable to add the process to the scheduler");
     }
 
     proc->state = RUNNING;
 }
 
+int scheduler_donate(proc_t *from, proc_t *to) {
+    cpu_t *cpu = cpu_this();
+
+    if (!from || !to || from == to) {
+        return -1;
+    }
+
+    // Real-time processes only run on the CPU they were admitted on, in
+    // deadline order
+    if (from->rt_period > 0 || to->rt_period > 0 || !scheduler_queued(to)) {
+        return -1;
+    }
+
+    if (to->cpu != cpu->id) {
+        proc_list_remove(to);
+        to->cpu = cpu->id;
+        scheduler_add(to);
+    }
+
+    // The donor gives up the rest of its time slice
+    from->active_time = 0;
+
+    cpu->donate = to;
+
+    return 0;
+}
+
 void scheduler_remove(proc_t *proc) {
-    int i;
-    int pid;
+    if (!proc) {
+        panic("Invalid process!");
+    }
+
+    // Sleeping processes are only held in the sleep queue; their time
+    // slice was already adapted when they went to sleep
+    if (proc->sleep_pos != 0) {
+        sleep_queue_remove(proc);
+        return;
+    }
+
+    scheduler_adapt_timeslice(proc, 0);
+
+    // Unlink the process from its run queue if it is scheduled
+    if (scheduler_queued(proc)) {
+        proc_list_remove(proc);
+    }
+}
+
+void scheduler_sleep(proc_t *proc, int wake_time) {
+    if (!proc) {
+        panic("Invalid process!");
+    }
+
+    if (proc->sleep_pos != 0) {
+        panic("Process is already sleeping!");
+    }
+
+    if (sleep_count >= PROC_MAX) {
+        panic("Unable to add the process to the sleep queue");
+    }
+
+    proc->state = SLEEPING;
+    proc->wake_time = wake_time;
+
+    scheduler_adapt_timeslice(proc, 0);
+
+    // Add the process to the tail of the heap and move it into position
+    sleep_count++;
+    sleep_queue_set(sleep_count, proc);
+    sleep_queue_up(sleep_count);
+}
+
+int scheduler_set_priority(proc_t *proc, int priority) {
+    if (!proc) {
+        panic("Invalid process!");
+    }
+
+    if (priority < PROC_PRIORITY_HIGH || priority > PROC_PRIORITY_LOW) {
+        return -1;
+    }
+
+    proc->priority = priority;
+    scheduler_set_level(proc, priority);
+
+    return 0;
+}
+
+int scheduler_set_tickets(proc_t *proc, int tickets) {
+    if (!proc) {
+        panic("Invalid process!");
+    }
+
+    if (tickets < 0 || tickets > PROC_TICKETS_MAX) {
+        return -1;
+    }
+
+    proc->tickets = tickets;
+    proc->stride = tickets > 0 ? STRIDE1 / tickets : 0;
+
+    // Start from the current pass of the CPU so the process neither gains
+    // nor loses out from joining the stride queue
+    proc->pass = cpus[proc->cpu].stride_pass;
+
+    // Move the process to the run queue for its scheduling class
+    if (scheduler_queued(proc)) {
+        scheduler_add(proc);
+    }
+
+    return 0;
+}
+
+int scheduler_set_timeslice(proc_t *proc, int ticks, int adaptive) {
+    if (!proc) {
+        panic("Invalid process!");
+    }
+
+    if (ticks != 0 && (ticks < PROC_TIMESLICE_MIN || ticks > PROC_TIMESLICE_MAX)) {
+        return -1;
+    }
+
+    proc->timeslice = ticks;
+    proc->timeslice_adaptive = adaptive ? 1 : 0;
+
+    return 0;
+}
+
+int scheduler_set_rt(proc_t *proc, int period, int budget, int deadline) {
+    cpu_t *cpu;
+    int util = 0;
 
     if (!proc) {
         panic("Invalid process!");
     }
 
-    for (i = 0; i < run_queue.size; i++) {
-        if (queue_out(&run_queue, &pid) != 0) {
-            panic("Unable to queue out the process entry");
+    cpu = &cpus[proc->cpu];
+
+    if (period < 0 || budget < 0 || deadline < 0) {
+        return -1;
+    }
+
+    if (period > 0) {
+        if (budget == 0 || budget > deadline || deadline > period) {
+            return -1;
         }
 
-        if (proc->pid == pid) {
-            // Found the process
-            break;
+        // Admit the process only if the CPU can still meet every deadline
+        // (reserving the share of the CPU each job needs by its deadline)
+        util = (budget * 1000 + deadline - 1) / deadline;
+
+        if (cpu->rt_util - proc->rt_util + util > SCHED_RT_UTIL_MAX) {
+            return -1;
         }
+    } else {
+        budget = 0;
+        deadline = 0;
+    }
+
+    cpu->rt_util += util - proc->rt_util;
 
-        // Add the item back to the run queue
-        if (queue_in(&run_queue, pid) != 0) {
-            panic("Unable to queue process back to the run queue");
+    proc->rt_period       = period;
+    proc->rt_budget       = budget;
+    proc->rt_rel_deadline = deadline;
+    proc->rt_util         = util;
+
+    // Release the first job the next time the process is scheduled
+    proc->rt_release   = system_time;
+    proc->rt_deadline  = system_time;
+    proc->rt_remaining = 0;
+
+    // Move the process to the run queue for its scheduling class
+    if (scheduler_queued(proc)) {
+        scheduler_add(proc);
+    }
+
+    return 0;
+}
+
+void scheduler_tick(proc_t *proc) {
+    // Charge the stride scheduling pass (MLFQ processes share one)
+    if (proc->tickets > 0) {
+        proc->pass += proc->stride;
+    } else if (proc->rt_period == 0 && !proc_is_idle(proc)) {
+        cpus[proc->cpu].mlfq_pass += STRIDE1 / SCHED_MLFQ_TICKETS;
+    }
+
+    // Charge the budget of the real-time job
+    if (proc->rt_period > 0) {
+        proc->rt_remaining--;
+    }
+}
+
+int scheduler_next_wake() {
+    if (sleep_count == 0) {
+        return -1;
+    }
+
+    return sleep_queue[1]->wake_time;
+}
+
+int scheduler_select_cpu() {
+    int i;
+    int load;
+    int min_load;
+    int cpu = 0;
+
+    min_load = scheduler_load(&cpus[0]);
+
+    for (i = 1; i < cpu_count; i++) {
+        load = scheduler_load(&cpus[i]);
+
+        if (load < min_load) {
+            min_load = load;
+            cpu = i;
         }
     }
+
+    return cpu;
 }
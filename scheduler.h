@@ -8,6 +8,31 @@
 #ifndef SCHEDULER_H
 #define SCHEDULER_H
 
+#include "syscall_defs.h"
+
+// Number of multi-level feedback queue levels (one per process priority)
+// The time slice at each level is the process time slice << level ticks
+#define SCHED_LEVELS        (PROC_PRIORITY_LOW + 1)
+
+// Number of ticks between boosting all processes back to their priority
+#define SCHED_BOOST_PERIOD  TIMER_MS(2000)
+
+// Stride scheduling: a process with N tickets advances its pass by
+// STRIDE1 / N for every tick it runs
+#define STRIDE1             (1 << 20)
+
+// Tickets held by all priority scheduled (MLFQ) processes together, so
+// that they share the CPU with stride processes rather than only running
+// when no stride process is ready
+#define SCHED_MLFQ_TICKETS  100
+
+// Maximum CPU share (per mille) that real-time processes may reserve on a
+// CPU; the remainder is kept for all other processes
+#define SCHED_RT_UTIL_MAX   900
+
+// Number of real-time deadlines missed
+extern int sched_rt_misses;
+
 /**
  * Initializes the scheduler
  */
@@ -30,4 +55,85 @@ void scheduler_add(proc_t *proc);
  */
 void scheduler_remove(proc_t *proc);
 
+/**
+ * Puts a process to sleep until the specified time
+ * @param proc - pointer to the process entry
+ * @param wake_time - system time when the process should be woken up
+ */
+void scheduler_sleep(proc_t *proc, int wake_time);
+
+/**
+ * Sets the base priority of a process
+ * @param proc - pointer to the process entry
+ * @param priority - priority (PROC_PRIORITY_HIGH to PROC_PRIORITY_LOW)
+ * @return 0 on success, -1 on error
+ */
+int scheduler_set_priority(proc_t *proc, int priority);
+
+/**
+ * Sets the stride scheduling tickets of a process
+ * Processes with tickets share the CPU in proportion to their tickets with
+ * each other and with the multi-level feedback queue (which holds
+ * SCHED_MLFQ_TICKETS)
+ * @param proc - pointer to the process entry
+ * @param tickets - number of tickets (0 to return to the feedback queue)
+ * @return 0 on success, -1 on error
+ */
+int scheduler_set_tickets(proc_t *proc, int tickets);
+
+/**
+ * Sets the time slice of a process
+ * In adaptive mode the time slice is halved each time the process blocks
+ * before using it up and doubled each time the process uses all of it,
+ * within PROC_TIMESLICE_MIN and PROC_TIMESLICE_MAX.
+ * @param proc - pointer to the process entry
+ * @param ticks - time slice in ticks (0 for the default time slice)
+ * @param adaptive - non-zero to adapt the time slice to the process
+ * @return 0 on success, -1 on error
+ */
+int scheduler_set_timeslice(proc_t *proc, int ticks, int adaptive);
+
+/**
+ * Sets the real-time scheduling parameters of a process
+ * Real-time processes are scheduled earliest deadline first, ahead of all
+ * other processes. The process is only admitted if the CPU share of all
+ * real-time processes on its CPU stays within SCHED_RT_UTIL_MAX.
+ * @param proc - pointer to the process entry
+ * @param period - ticks between job releases (0 to stop being real-time)
+ * @param budget - CPU ticks each job may use
+ * @param deadline - ticks after each release the job must finish by
+ * @return 0 on success, -1 on error or if the process cannot be admitted
+ */
+int scheduler_set_rt(proc_t *proc, int period, int budget, int deadline);
+
+/**
+ * Gives up the CPU of a process in favor of another process
+ * The receiver is moved to the executing CPU and is the next process the
+ * scheduler runs unless a more important process is waiting. The caller
+ * must then unschedule the donor (which starts a new time slice when it
+ * runs again). Real-time processes cannot donate or receive the CPU.
+ * @param from - process giving up the CPU (the current process)
+ * @param to - process to run next (must be in the run queues)
+ * @return 0 on success, -1 if the CPU cannot be given to the process
+ */
+int scheduler_donate(proc_t *from, proc_t *to);
+
+/**
+ * Charges a timer tick to a process
+ * @param proc - pointer to the process entry that was running
+ */
+void scheduler_tick(proc_t *proc);
+
+/**
+ * Returns the earliest wake time of all sleeping processes
+ * @return system time of the next wake up, -1 if no processes are sleeping
+ */
+int scheduler_next_wake();
+
+/**
+ * Selects the CPU with the fewest waiting processes
+ * @return CPU index
+ */
+int scheduler_select_cpu();
+
 #endif
@@ -0,0 +1,185 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2021
+ *
+ * Symmetric multiprocessing support
+ */
+
+#include <spede/flames.h>
+#include <spede/stdio.h>
+#include <spede/string.h>
+
+#include "interrupts.h"
+#include "kernel.h"
+#include "kutil.h"
+#include "clockevent.h"
+#include "fpu.h"
+#include "lapic.h"
+#include "scheduler.h"
+#include "smp.h"
+
+// Time to wait for the application processors to check in (microseconds)
+#define SMP_STARTUP_WAIT 100000
+
+// Per-CPU data
+cpu_t cpus[CPU_MAX];
+
+// Number of CPUs running
+int cpu_count;
+
+// CPU index for each local APIC ID
+unsigned char cpu_apic_index[256];
+
+// Kernel lock
+volatile int kernel_lock;
+
+// Number of application processors that have started (see smp_entry.S)
+volatile int smp_ap_next;
+
+/**
+ * Busy waits for approximately the given number of microseconds
+ */
+static void smp_delay(int usec) {
+    while (usec-- > 0) {
+        IO_DELAY();
+    }
+}
+
+/**
+ * Takes the kernel lock, spinning until it is available
+ */
+void kernel_lock_acquire() {
+    int locked = 1;
+
+    do {
+        asm volatile("xchgl %0, %1"
+                     : "+r"(locked), "+m"(kernel_lock)
+                     :
+                     : "memory");
+
+        if (locked) {
+            asm volatile("pause");
+        }
+    } while (locked);
+}
+
+/**
+ * Releases the kernel lock
+ */
+void kernel_lock_release() {
+    asm volatile("" : : : "memory");
+    kernel_lock = 0;
+}
+
+/**
+ * Initializes the per-CPU data and starts the application processors
+ * The application processors wait for the kernel lock before scheduling
+ */
+void smp_init() {
+    int i;
+    int started;
+    unsigned short *desc;
+
+    printf("Initializing SMP\n");
+
+    memset(cpu_apic_index, 0, sizeof(cpu_apic_index));
+
+    for (i = 0; i < CPU_MAX; i++) {
+        cpus[i].id = i;
+    }
+
+    // The bootstrap processor is CPU 0
+    lapic_init();
+    cpus[0].apic_id = lapic_id();
+    cpus[0].started = 1;
+    cpu_apic_index[cpus[0].apic_id] = 0;
+    cpu_count = 1;
+
+    // Application processors need a tick device of their own
+    if (!clockevent->percpu) {
+        printf("%s cannot tick on other CPUs; running on a single CPU\n", clockevent->name);
+        return;
+    }
+
+    // Copy the startup code to low memory along with the descriptor tables
+    // the application processors need to enter protected mode
+    memcpy((void *)SMP_TRAMPOLINE_ADDR, smp_trampoline_start,
+           smp_trampoline_end - smp_trampoline_start);
+
+    desc = (unsigned short *)(SMP_TRAMPOLINE_ADDR + (smp_trampoline_gdt - smp_trampoline_start));
+    asm volatile("sgdt %0" : "=m"(*desc));
+
+    desc = (unsigned short *)(SMP_TRAMPOLINE_ADDR + (smp_trampoline_idt - smp_trampoline_start));
+    asm volatile("sidt %0" : "=m"(*desc));
+
+    // INIT-SIPI-SIPI sequence to start all application processors
+    smp_ap_next = 0;
+
+    lapic_ipi_init_all();
+    smp_delay(10000);
+
+    lapic_ipi_startup_all(SMP_TRAMPOLINE_ADDR >> 12);
+    smp_delay(200);
+
+    lapic_ipi_startup_all(SMP_TRAMPOLINE_ADDR >> 12);
+    smp_delay(SMP_STARTUP_WAIT);
+
+    // Count the application processors that checked in
+    started = smp_ap_next;
+
+    if (started > CPU_MAX - 1) {
+        started = CPU_MAX - 1;
+    }
+
+    for (i = 1; i <= started; i++) {
+        if (cpus[i].started) {
+            cpu_count++;
+        }
+    }
+
+    printf("%d CPU(s) running\n", cpu_count);
+}
+
+/**
+ * Application processor entry point (called from smp_entry.S on the CPU's
+ * kernel stack)
+ * @param id - CPU index
+ */
+void smp_ap_main(int id) {
+    cpu_t *cpu = &cpus[id];
+
+    lapic_init();
+
+    cpu->apic_id = lapic_id();
+    cpu_apic_index[cpu->apic_id] = id;
+    cpu->started = 1;
+
+    // Wait for the bootstrap processor to finish initializing the kernel
+    kernel_lock_acquire();
+
+    // The bootstrap processor may have given up waiting for this CPU
+    if (id >= cpu_count || !cpu->idle) {
+        kernel_lock_release();
+
+        while (1) {
+            asm("cli");
+            asm("hlt");
+        }
+    }
+
+    // Start the periodic tick for this CPU
+    clockevent_cpu_init();
+
+    // Enable the fast system call entry for this CPU
+    sysenter_init(id);
+
+    // Enable the FPU for this CPU
+    fpu_cpu_init();
+
+    // Run the scheduler and switch to the first process
+    scheduler_run();
+    kernel_account_exit();
+    fpu_switch(current);
+    kernel_context_switch(current->trapframe);
+}
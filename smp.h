@@ -0,0 +1,100 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2021
+ *
+ * Symmetric multiprocessing support
+ */
+#ifndef SMP_H
+#define SMP_H
+
+// Maximum number of CPUs supported
+#define CPU_MAX 8
+
+// Physical address the application processors start executing at
+// (must be page aligned and below 1MB)
+#define SMP_TRAMPOLINE_ADDR 0x8000
+
+#ifndef ASSEMBLER
+
+#include "kproc.h"
+#include "lapic.h"
+#include "scheduler.h"
+
+// Per-CPU data
+typedef struct cpu_t {
+    int id;                                 // CPU index
+    int apic_id;                            // Local APIC ID
+    volatile int started;                   // CPU has checked in
+    proc_t *current;                        // Process executing on the CPU
+    proc_t *idle;                           // Idle task for the CPU
+    proc_t *donate;                         // Process given the CPU by the
+                                            // last process (see scheduler_donate())
+    proc_list_t run_queue[SCHED_LEVELS];    // Running processes
+    proc_list_t stride_queue;               // Stride processes (by pass)
+    int stride_pass;                        // Pass of the last stride process run
+    int mlfq_pass;                          // Stride pass of the MLFQ processes
+    proc_list_t edf_queue;                  // Real-time processes (by deadline)
+    int rt_util;                            // CPU share reserved by real-time processes
+    unsigned long long tsc_enter;           // Time stamp when the kernel was entered
+    unsigned long long tsc_exit;            // Time stamp when the kernel was left
+    unsigned long long kernel_cycles;       // Cycles spent in the kernel
+    int nohz_ticks;                         // Ticks the tick is stopped for
+    unsigned long long clock_next;          // Time stamp of the next tick
+                                            // (TSC-deadline timer only)
+    proc_t *fpu_owner;                      // Process whose state the FPU holds
+    proc_t *fpu_last;                       // Process last switched to
+    int fpu_live;                           // FPU usable without trapping
+                                            // (CR0.TS clear)
+} cpu_t;
+
+// Per-CPU data for each CPU
+extern cpu_t cpus[CPU_MAX];
+
+// Number of CPUs running
+extern int cpu_count;
+
+// CPU index for each local APIC ID
+extern unsigned char cpu_apic_index[256];
+
+// Kernel lock (held while any CPU is executing in the kernel)
+extern volatile int kernel_lock;
+
+/**
+ * Returns the per-CPU data of the executing CPU
+ */
+#define cpu_this() (&cpus[cpu_apic_index[lapic_id()]])
+
+/**
+ * Determines if a process is the idle task of a CPU
+ */
+#define proc_is_idle(proc) ((proc) == cpus[(proc)->cpu].idle)
+
+/**
+ * Initializes the per-CPU data and starts the application processors
+ * The application processors wait for the kernel lock before scheduling
+ */
+void smp_init();
+
+/**
+ * Takes the kernel lock, spinning until it is available
+ */
+void kernel_lock_acquire();
+
+/**
+ * Releases the kernel lock
+ */
+void kernel_lock_release();
+
+/* Defined in smp_entry.S */
+__BEGIN_DECLS
+
+// Application processor startup code (copied to SMP_TRAMPOLINE_ADDR)
+extern char smp_trampoline_start[];
+extern char smp_trampoline_gdt[];
+extern char smp_trampoline_idt[];
+extern char smp_trampoline_end[];
+
+__END_DECLS
+#endif
+#endif
@@ -6,6 +6,46 @@
  * System call APIs
  */
 #include "syscall.h"
+#include "x86.h"
+
+// Fast system calls (SYSENTER) are supported: -1 until checked
+static int syscall_sysenter = -1;
+
+/*
+ * Triggers a system call through the fastest available entry
+ * SYSENTER is used when the CPU supports it, otherwise int 0x80
+ * @param syscall - system call
+ * @param arg1, arg2, arg3 - system call arguments
+ * @return system call return value
+ */
+static int syscall_fast(int syscall, int arg1, int arg2, int arg3) {
+    unsigned int a, b, c, d;
+    int rc;
+
+    if (syscall_sysenter < 0) {
+        cpuid(CPUID_FEATURES, a, b, c, d);
+        syscall_sysenter = (d & CPUID_EDX_SEP) ? 1 : 0;
+    }
+
+    if (syscall_sysenter) {
+        // The kernel returns to the address in esi on the stack in ebp
+        asm volatile("pushl %%ebp;"
+                     "movl %%esp, %%ebp;"
+                     "movl $1f, %%esi;"
+                     "sysenter;"
+                     "1: popl %%ebp;"
+                     : "=a"(rc), "+b"(arg1), "+c"(arg2), "+d"(arg3)
+                     : "0"(syscall)
+                     : "%esi", "memory", "cc");
+    } else {
+        asm volatile("int $0x80;"
+                     : "=a"(rc), "+b"(arg1), "+c"(arg2), "+d"(arg3)
+                     : "0"(syscall)
+                     : "memory", "cc");
+    }
+
+    return rc;
+}
 
 
 /*
@@ -23,14 +63,38 @@ void sleep(int seconds) {
 
 
 /*
- * Allows a process to indicate that it can relinquish control of the CPU
+ * Puts the current process to sleep for the specified number of milliseconds
+ * @param ms - number of milliseconds the process should sleep
  */
-void yield(void) {
+void msleep(int ms) {
     asm("movl %0, %%eax;"
+        "movl %1, %%ebx;"
         "int $0x80;"
         :
-        : "g"(SYSCALL_YIELD)
-        : "%eax");
+        : "g"(SYSCALL_MSLEEP), "g"(ms)
+        : "%eax", "%ebx");
+}
+
+
+/*
+ * Puts the current process to sleep for the specified number of microseconds
+ * @param us - number of microseconds the process should sleep
+ */
+void usleep(int us) {
+    asm("movl %0, %%eax;"
+        "movl %1, %%ebx;"
+        "int $0x80;"
+        :
+        : "g"(SYSCALL_USLEEP), "g"(us)
+        : "%eax", "%ebx");
+}
+
+
+/*
+ * Allows a process to indicate that it can relinquish control of the CPU
+ */
+void yield(void) {
+    syscall_fast(SYSCALL_YIELD, 0, 0, 0);
 }
 
 
@@ -39,16 +103,88 @@ void yield(void) {
  * @return system time in seconds
  */
 int sys_get_time() {
-    int time = -1;
+    return syscall_fast(SYSCALL_SYS_GET_TIME, 0, 0, 0);
+}
+
+
+/*
+ * Gets the current system time (in milliseconds)
+ * @return system time in milliseconds
+ */
+int sys_get_time_ms() {
+    return syscall_fast(SYSCALL_SYS_GET_TIME_MS, 0, 0, 0);
+}
+
+
+/*
+ * Gets the timer tick rate
+ * @return number of ticks per second
+ */
+int sys_get_hz() {
+    int hz = -1;
 
     asm("movl %1, %%eax;"
         "int $0x80;"
         "movl %%eax, %0;"
-        : "=g"(time)
-        : "g"(SYSCALL_SYS_GET_TIME)
+        : "=g"(hz)
+        : "g"(SYSCALL_SYS_GET_HZ)
         : "%eax");
 
-    return time;
+    return hz;
+}
+
+
+/*
+ * Reads a key typed on the keyboard
+ * @param key - where to store the key
+ * @return 0 on success, -1 on error
+ */
+int sys_read_key(char *key) {
+    return syscall_fast(SYSCALL_SYS_READ_KEY, (int)key, 0, 0);
+}
+
+
+/*
+ * Writes characters to the serial console
+ * @param buf - characters to write
+ * @param len - number of characters
+ * @return -1 on error, otherwise the number of characters written
+ */
+int sys_write(char *buf, int len) {
+    return syscall_fast(SYSCALL_SYS_WRITE, (int)buf, len, 0);
+}
+
+
+/*
+ * Runs several system calls with a single entry into the kernel
+ * @param calls - system calls to run
+ * @param count - number of system calls
+ * @return -1 on error, otherwise the number of system calls that ran
+ */
+int sys_batch(syscall_batch_t *calls, int count) {
+    return syscall_fast(SYSCALL_BATCH, (int)calls, count, 0);
+}
+
+
+/*
+ * Gets the usage statistics of a system call
+ * @param syscall - system call number
+ * @param stats - pointer to the statistics to fill in
+ * @return -1 on error, 0 on success
+ */
+int sys_get_syscall_stats(int syscall, syscall_stats_t *stats) {
+    int rc = -1;
+
+    asm("movl %1, %%eax;"
+        "movl %2, %%ebx;"
+        "movl %3, %%ecx;"
+        "int $0x80;"
+        "movl %%eax, %0;"
+        : "=g"(rc)
+        : "g"(SYSCALL_SYS_GET_SYSCALL_STATS), "g"(syscall), "g"(stats)
+        : "%eax", "%ebx", "%ecx");
+
+    return rc;
 }
 
 
@@ -88,16 +224,7 @@ void proc_exit() {
  * @return process id
  */
 int proc_get_pid() {
-    int pid = -1;
-
-    asm("movl %1, %%eax;"
-        "int $0x80;"
-        "movl %%eax, %0;"
-        : "=g"(pid)
-        : "g"(SYSCALL_PROC_GET_PID)
-        : "%eax");
-
-    return pid;
+    return syscall_fast(SYSCALL_PROC_GET_PID, 0, 0, 0);
 }
 
 
@@ -163,25 +290,183 @@ int mutex_free(int mutex) {
  * @note If the mutex is already locked, process will block/wait.
  */
 int mutex_lock(int mutex) {
+    return syscall_fast(SYSCALL_MUTEX_LOCK, mutex, 0, 0);
+}
+
+/**
+ * Unlocks the mutex
+ * @return -1 on error, 0 on sucecss
+ * @param *mutex - pointer to the mutex identifier
+ */
+int mutex_unlock(int mutex) {
+    return syscall_fast(SYSCALL_MUTEX_UNLOCK, mutex, 0, 0);
+}
+
+/**
+ * Sends a message to the specified mailbox
+ * @param mbox - Mailbox number to send to
+ * @param msg - Pointer to the message data structure
+ * @return -1 on error, 0 on success
+ */
+int msg_send(int mbox, msg_t *msg) {
+    return syscall_fast(SYSCALL_MSG_SEND, mbox, (int)msg, 0);
+}
+
+/**
+ * Sends a message to the specified mailbox and, if a process is waiting
+ * for it, gives the rest of the time slice to the receiver
+ * @param mbox - Mailbox number to send to
+ * @param msg - Pointer to the message data structure
+ * @return -1 on error, 0 on success
+ */
+int msg_send_donate(int mbox, msg_t *msg) {
+    return syscall_fast(SYSCALL_MSG_SEND_DONATE, mbox, (int)msg, 0);
+}
+
+/**
+ * Receives a message from the specified mailbox
+ * This call is blocking; if no message exists in the mailbox, the system
+ * call will block (process moves to WAITING state)
+ *
+ * @param mbox - Mailbox number to send to
+ * @param msg - Pointer to the message data structure
+ * @return -1 on error, 0 on success
+ */
+int msg_recv(int mbox, msg_t *msg) {
+    return syscall_fast(SYSCALL_MSG_RECV, mbox, (int)msg, 0);
+}
+
+/**
+ * Sends only the first bytes of a message's data to the specified mailbox
+ * @param mbox - Mailbox number to send to
+ * @param msg - Pointer to the message data structure
+ * @param size - Number of bytes of data to send
+ * @return -1 on error, 0 on success
+ */
+int msg_send_size(int mbox, msg_t *msg, int size) {
+    return syscall_fast(SYSCALL_MSG_SEND_SIZE, mbox, (int)msg, size);
+}
+
+/**
+ * Receives a message from the specified mailbox, copying at most the given
+ * number of bytes of data
+ * @param mbox - Mailbox number to receive from
+ * @param msg - Pointer to the message data structure
+ * @param size - Number of bytes of data to receive
+ * @return -1 on error, 0 on success
+ */
+int msg_recv_size(int mbox, msg_t *msg, int size) {
+    return syscall_fast(SYSCALL_MSG_RECV_SIZE, mbox, (int)msg, size);
+}
+
+/**
+ * Receives a message from the specified mailbox if one is waiting
+ * @param mbox - Mailbox number to receive from
+ * @param msg - Pointer to the message data structure
+ * @return -1 on error or if the mailbox is empty, 0 on success
+ */
+int msg_try_recv(int mbox, msg_t *msg) {
+    return syscall_fast(SYSCALL_MSG_TRY_RECV, mbox, (int)msg, 0);
+}
+
+/**
+ * Receives a message from the specified mailbox, waiting up to the given
+ * time for one to arrive
+ * @param mbox - Mailbox number to receive from
+ * @param msg - Pointer to the message data structure
+ * @param ms - Milliseconds to wait
+ * @return -1 on error or if no message arrived in time, 0 on success
+ */
+int msg_recv_timeout(int mbox, msg_t *msg, int ms) {
+    return syscall_fast(SYSCALL_MSG_RECV_TIMEOUT, mbox, (int)msg, ms);
+}
+
+/**
+ * Waits until any of the given mailboxes has a message
+ * @param mboxes - Mailbox numbers to wait on
+ * @param count - Number of mailboxes
+ * @return -1 on error, otherwise the first mailbox with a message
+ */
+int msg_select(int *mboxes, int count) {
+    return syscall_fast(SYSCALL_MSG_SELECT, (int)mboxes, count, 0);
+}
+
+/**
+ * Sends a message buffer to the specified mailbox without copying it
+ * @param mbox - Mailbox number to send to
+ * @param msg - Pointer to the message data structure
+ * @param buf - Message buffer handle
+ * @return -1 on error, 0 on success
+ */
+int msg_send_buf(int mbox, msg_t *msg, int buf) {
+    return syscall_fast(SYSCALL_MSG_SEND_BUF, mbox, (int)msg, buf);
+}
+
+/**
+ * Allocates a message buffer
+ * @param size - Size of the buffer in bytes
+ * @param data - Set to the address of the buffer
+ * @return -1 on error, otherwise the buffer handle
+ */
+int msg_buf_alloc(int size, void **data) {
+    return syscall_fast(SYSCALL_MSG_BUF_ALLOC, size, (int)data, 0);
+}
+
+/**
+ * Looks up the address of a message buffer
+ * @param buf - Message buffer handle
+ * @param data - Set to the address of the buffer
+ * @return -1 on error, otherwise the size of the buffer in bytes
+ */
+int msg_buf_map(int buf, void **data) {
+    return syscall_fast(SYSCALL_MSG_BUF_MAP, buf, (int)data, 0);
+}
+
+/**
+ * Takes another reference to a message buffer
+ * @param buf - Message buffer handle
+ * @return -1 on error, 0 on success
+ */
+int msg_buf_dup(int buf) {
+    return syscall_fast(SYSCALL_MSG_BUF_DUP, buf, 0, 0);
+}
+
+/**
+ * Releases a reference to a message buffer
+ * @param buf - Message buffer handle
+ * @return -1 on error, 0 on success
+ */
+int msg_buf_release(int buf) {
+    return syscall_fast(SYSCALL_MSG_BUF_RELEASE, buf, 0, 0);
+}
+
+/**
+ * Sets the scheduling priority of a process
+ * @param pid - process id
+ * @param priority - PROC_PRIORITY_HIGH (0) to PROC_PRIORITY_LOW
+ * @return -1 on error, 0 on success
+ */
+int proc_set_priority(int pid, int priority) {
     int rc = -1;
 
     asm("movl %1, %%eax;"
         "movl %2, %%ebx;"
+        "movl %3, %%ecx;"
         "int $0x80;"
         "movl %%eax, %0;"
         : "=g"(rc)
-        : "g"(SYSCALL_MUTEX_LOCK), "g"(mutex)
-        : "%eax", "%ebx");
+        : "g"(SYSCALL_PROC_SET_PRIORITY), "g"(pid), "g"(priority)
+        : "%eax", "%ebx", "%ecx");
 
     return rc;
 }
 
 /**
- * Unlocks the mutex
- * @return -1 on error, 0 on sucecss
- * @param *mutex - pointer to the mutex identifier
+ * Gets the scheduling priority of a process
+ * @param pid - process id
+ * @return -1 on error, otherwise the priority of the process
  */
-int mutex_unlock(int mutex) {
+int proc_get_priority(int pid) {
     int rc = -1;
 
     asm("movl %1, %%eax;"
@@ -189,55 +474,94 @@ int mutex_unlock(int mutex) {
         "int $0x80;"
         "movl %%eax, %0;"
         : "=g"(rc)
-        : "g"(SYSCALL_MUTEX_UNLOCK), "g"(mutex)
+        : "g"(SYSCALL_PROC_GET_PRIORITY), "g"(pid)
         : "%eax", "%ebx");
 
     return rc;
 }
 
 /**
- * Sends a message to the specified mailbox
- * @param mbox - Mailbox number to send to
- * @param msg - Pointer to the message data structure
+ * Sets the stride scheduling tickets of a process
+ * @param pid - process id
+ * @param tickets - number of tickets, or 0 to return to priority scheduling
  * @return -1 on error, 0 on success
  */
-int msg_send(int mbox, msg_t *msg) {
+int proc_set_tickets(int pid, int tickets) {
     int rc = -1;
 
-    // Trigger the system call
     asm("movl %1, %%eax;"
         "movl %2, %%ebx;"
         "movl %3, %%ecx;"
         "int $0x80;"
         "movl %%eax, %0;"
         : "=g"(rc)
-        : "g"(SYSCALL_MSG_SEND), "g"(mbox), "g"(msg)
-        : "%eax");
+        : "g"(SYSCALL_PROC_SET_TICKETS), "g"(pid), "g"(tickets)
+        : "%eax", "%ebx", "%ecx");
 
     return rc;
 }
 
 /**
- * Receives a message from the specified mailbox
- * This call is blocking; if no message exists in the mailbox, the system
- * call will block (process moves to WAITING state)
- *
- * @param mbox - Mailbox number to send to
- * @param msg - Pointer to the message data structure
+ * Sets the time slice of a process
+ * @param pid - process id
+ * @param ticks - time slice in ticks, or 0 for the default time slice
+ * @param adaptive - non-zero to adapt the time slice to the process
  * @return -1 on error, 0 on success
  */
-int msg_recv(int mbox, msg_t *msg) {
+int proc_set_timeslice(int pid, int ticks, int adaptive) {
     int rc = -1;
 
-    // Trigger the system call
     asm("movl %1, %%eax;"
         "movl %2, %%ebx;"
         "movl %3, %%ecx;"
+        "movl %4, %%edx;"
         "int $0x80;"
         "movl %%eax, %0;"
         : "=g"(rc)
-        : "g"(SYSCALL_MSG_RECV), "g"(mbox), "g"(msg)
-        : "%eax");
+        : "g"(SYSCALL_PROC_SET_TIMESLICE), "g"(pid), "g"(ticks), "g"(adaptive)
+        : "%eax", "%ebx", "%ecx", "%edx");
+
+    return rc;
+}
+
+/**
+ * Gets the CPU time used by a process
+ * @param pid - process id
+ * @param usage - pointer to the usage to fill in
+ * @return -1 on error, 0 on success
+ */
+int proc_get_usage(int pid, proc_usage_t *usage) {
+    int rc = -1;
+
+    asm("movl %1, %%eax;"
+        "movl %2, %%ebx;"
+        "movl %3, %%ecx;"
+        "int $0x80;"
+        "movl %%eax, %0;"
+        : "=g"(rc)
+        : "g"(SYSCALL_PROC_GET_USAGE), "g"(pid), "g"(usage)
+        : "%eax", "%ebx", "%ecx");
+
+    return rc;
+}
+
+/**
+ * Sets the real-time scheduling parameters of a process
+ * @param pid - process id
+ * @param params - pointer to the real-time parameters
+ * @return -1 on error, 0 on success
+ */
+int proc_set_rt(int pid, rt_params_t *params) {
+    int rc = -1;
+
+    asm("movl %1, %%eax;"
+        "movl %2, %%ebx;"
+        "movl %3, %%ecx;"
+        "int $0x80;"
+        "movl %%eax, %0;"
+        : "=g"(rc)
+        : "g"(SYSCALL_PROC_SET_RT), "g"(pid), "g"(params)
+        : "%eax", "%ebx", "%ecx");
 
     return rc;
 }
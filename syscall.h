@@ -27,6 +27,63 @@ void proc_exit(void);
  */
 int sys_get_time(void);
 
+/**
+ * Gets the current system time (in milliseconds)
+ * @return system time in milliseconds
+ */
+int sys_get_time_ms(void);
+
+/**
+ * Gets the timer tick rate
+ * Scheduling parameters such as time slices are given in ticks
+ * @return number of ticks per second
+ */
+int sys_get_hz(void);
+
+/**
+ * Reads a key typed on the keyboard
+ * Waits until a key is typed if none is available. Keys typed while no
+ * process is waiting for one may instead be taken as kernel commands, as
+ * is any key typed after the command prefix (Escape).
+ * @param key - where to store the key
+ * @return 0 on success, -1 on error
+ */
+int sys_read_key(char *key);
+
+/**
+ * Writes characters to the serial console
+ * Characters are buffered until the end of the line so lines written by
+ * different processes are not mixed together. Writing never waits;
+ * characters are dropped if the console cannot keep up.
+ * @param buf - characters to write
+ * @param len - number of characters
+ * @return -1 on error, otherwise the number of characters written
+ */
+int sys_write(char *buf, int len);
+
+/**
+ * Runs several system calls with a single entry into the kernel
+ * The system calls are run in order. The batch stops after the first one
+ * that blocks (such as sleep or msg_recv on an empty mailbox) and returns
+ * once the process resumes; the return value of each system call that ran
+ * is stored with it. A system call flagged SYSCALL_BATCH_STOP_ON_ERROR
+ * also ends the batch if it fails.
+ * @param calls - system calls to run
+ * @param count - number of system calls (up to SYSCALL_BATCH_MAX)
+ * @return -1 on error, otherwise the number of system calls that ran
+ */
+int sys_batch(syscall_batch_t *calls, int count);
+
+/**
+ * Gets the usage statistics of a system call
+ * The kernel counts the calls made to each system call and the time spent
+ * handling them; the time does not include time spent blocked.
+ * @param syscall - system call number (0 to SYSCALL_MAX - 1)
+ * @param stats - pointer to the statistics to fill in
+ * @return -1 on error, 0 on success
+ */
+int sys_get_syscall_stats(int syscall, syscall_stats_t *stats);
+
 /**
  * Gets the current process' id
  * @return process id
@@ -46,6 +103,20 @@ int proc_get_name(char *name);
  */
 void sleep(int seconds);
 
+/**
+ * Puts the current process to sleep for the specified number of milliseconds
+ * The sleep is rounded up to a whole number of ticks
+ * @param ms - number of milliseconds the process should sleep
+ */
+void msleep(int ms);
+
+/**
+ * Puts the current process to sleep for the specified number of microseconds
+ * The sleep is rounded up to a whole number of ticks
+ * @param us - number of microseconds the process should sleep
+ */
+void usleep(int us);
+
 /**
  * Allows a process to indicate that it can relinquish control of the CPU
  */
@@ -78,8 +149,6 @@ int mutex_lock(int mutex);
  */
 int mutex_unlock(int mutex);
 
-#endif
-
 /**
  * Sends a message to the specified mailbox
  * @param mbox - Mailbox number to send to
@@ -88,6 +157,16 @@ int mutex_unlock(int mutex);
  */
 int msg_send(int mbox, msg_t *msg);
 
+/**
+ * Sends a message to the specified mailbox and, if a process is waiting
+ * for it, gives the rest of the time slice to the receiver so it runs
+ * next (useful for request/response exchanges)
+ * @param mbox - Mailbox number to send to
+ * @param msg - Pointer to the message data structure
+ * @return -1 on error, 0 on success
+ */
+int msg_send_donate(int mbox, msg_t *msg);
+
 /**
  * Receives a message from the specified mailbox
  * This call is blocking; if no message exists in the mailbox, the system
@@ -99,3 +178,179 @@ int msg_send(int mbox, msg_t *msg);
  */
 int msg_recv(int mbox, msg_t *msg);
 
+/**
+ * Sends only the first bytes of a message's data to the specified mailbox
+ * Small messages are cheaper to send, store and receive.
+ * @param mbox - Mailbox number to send to
+ * @param msg - Pointer to the message data structure
+ * @param size - Number of bytes of data to send (up to MSG_SIZE)
+ * @return -1 on error, 0 on success
+ */
+int msg_send_size(int mbox, msg_t *msg, int size);
+
+/**
+ * Receives a message from the specified mailbox, copying at most the given
+ * number of bytes of data (any more are discarded)
+ * Blocks like msg_recv(). The message size is set to the number of bytes
+ * of data received.
+ * @param mbox - Mailbox number to receive from
+ * @param msg - Pointer to the message data structure
+ * @param size - Number of bytes of data to receive (up to MSG_SIZE)
+ * @return -1 on error, 0 on success
+ */
+int msg_recv_size(int mbox, msg_t *msg, int size);
+
+/**
+ * Receives a message from the specified mailbox if one is waiting
+ * Never blocks.
+ * @param mbox - Mailbox number to receive from
+ * @param msg - Pointer to the message data structure
+ * @return -1 on error or if the mailbox is empty, 0 on success
+ */
+int msg_try_recv(int mbox, msg_t *msg);
+
+/**
+ * Receives a message from the specified mailbox, waiting up to the given
+ * time for one to arrive
+ * Cannot be used in a batch (see sys_batch()).
+ * @param mbox - Mailbox number to receive from
+ * @param msg - Pointer to the message data structure
+ * @param ms - Milliseconds to wait (0 to not wait)
+ * @return -1 on error or if no message arrived in time, 0 on success
+ */
+int msg_recv_timeout(int mbox, msg_t *msg, int ms);
+
+/**
+ * Waits until any of the given mailboxes has a message
+ * The message is not received; the caller receives it from the returned
+ * mailbox. Another process may receive it first, so servers sharing
+ * mailboxes should use msg_try_recv().
+ * Cannot be used in a batch (see sys_batch()).
+ * @param mboxes - Mailbox numbers to wait on (up to MBOX_MAX)
+ * @param count - Number of mailboxes
+ * @return -1 on error, otherwise the first mailbox with a message
+ */
+int msg_select(int *mboxes, int count);
+
+/**
+ * Sends a message buffer to the specified mailbox without copying it
+ * The caller's reference to the buffer moves to the message; the caller
+ * must not use the buffer afterwards unless it holds another reference
+ * (see msg_buf_dup()). The receiver finds the buffer handle in msg->buf and
+ * must release it once done with it. No other data is sent.
+ * @param mbox - Mailbox number to send to
+ * @param msg - Pointer to the message data structure
+ * @param buf - Message buffer handle
+ * @return -1 on error, 0 on success
+ */
+int msg_send_buf(int mbox, msg_t *msg, int buf);
+
+/**
+ * Allocates a message buffer for passing large amounts of data
+ * @param size - Size of the buffer in bytes (up to MSGBUF_SIZE)
+ * @param data - Set to the address of the buffer
+ * @return -1 on error, otherwise the buffer handle
+ */
+int msg_buf_alloc(int size, void **data);
+
+/**
+ * Looks up the address of a message buffer (such as one received)
+ * @param buf - Message buffer handle
+ * @param data - Set to the address of the buffer
+ * @return -1 on error, otherwise the size of the buffer in bytes
+ */
+int msg_buf_map(int buf, void **data);
+
+/**
+ * Takes another reference to a message buffer so it can be sent more than
+ * once
+ * @param buf - Message buffer handle
+ * @return -1 on error, 0 on success
+ */
+int msg_buf_dup(int buf);
+
+/**
+ * Releases a reference to a message buffer
+ * The buffer is freed once every reference has been released.
+ * @param buf - Message buffer handle
+ * @return -1 on error, 0 on success
+ */
+int msg_buf_release(int buf);
+
+/**
+ * Sets the scheduling priority of a process
+ * Higher priority processes are always scheduled ahead of lower priority
+ * processes; processes that use a lot of CPU time are demoted and are
+ * periodically boosted back to their priority.
+ *
+ * @param pid - process id
+ * @param priority - PROC_PRIORITY_HIGH (0) to PROC_PRIORITY_LOW
+ * @return -1 on error, 0 on success
+ */
+int proc_set_priority(int pid, int priority);
+
+/**
+ * Gets the scheduling priority of a process
+ * @param pid - process id
+ * @return -1 on error, otherwise the priority of the process
+ */
+int proc_get_priority(int pid);
+
+/**
+ * Sets the stride scheduling tickets of a process
+ * Processes holding tickets share the CPU in proportion to the number of
+ * tickets each one holds. All priority scheduled processes together hold
+ * SCHED_MLFQ_TICKETS tickets, so they keep a share of the CPU as well.
+ *
+ * @param pid - process id
+ * @param tickets - number of tickets (1 to PROC_TICKETS_MAX), or 0 to
+ *                  return to priority based scheduling
+ * @return -1 on error, 0 on success
+ */
+int proc_set_tickets(int pid, int tickets);
+
+/**
+ * Sets the time slice of a process
+ * In adaptive mode the time slice shrinks while the process keeps blocking
+ * before it is used up (favoring quick responses) and grows while the
+ * process keeps using all of it (favoring fewer context switches).
+ *
+ * @param pid - process id
+ * @param ticks - time slice in ticks (PROC_TIMESLICE_MIN to
+ *                PROC_TIMESLICE_MAX), or 0 for the default time slice
+ * @param adaptive - non-zero to adapt the time slice to the process
+ * @return -1 on error, 0 on success
+ */
+int proc_set_timeslice(int pid, int ticks, int adaptive);
+
+/**
+ * Gets the CPU time used by a process
+ * CPU time is measured with the time stamp counter each time the process
+ * is switched to and from, so it is accurate to the cycle rather than to
+ * the timer tick.
+ *
+ * @param pid - process id
+ * @param usage - pointer to the usage to fill in
+ * @return -1 on error, 0 on success
+ */
+int proc_get_usage(int pid, proc_usage_t *usage);
+
+/**
+ * Sets the real-time scheduling parameters of a process
+ * Real-time processes are scheduled earliest deadline first, ahead of all
+ * other processes. Each period a new job is released that may run for up
+ * to the budget and must complete by the deadline; a job ends early when
+ * the process sleeps or yields. A process blocked waiting (such as for a
+ * mutex or a message) keeps the rest of its job's budget. The request is
+ * refused if the CPU cannot guarantee the deadlines of all of its
+ * real-time processes.
+ *
+ * @param pid - process id
+ * @param params - pointer to the real-time parameters (a period of 0
+ *                 returns the process to its previous scheduling class)
+ * @return -1 on error or if the process cannot be admitted, 0 on success
+ */
+int proc_set_rt(int pid, rt_params_t *params);
+
+#endif
+
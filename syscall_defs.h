@@ -8,6 +8,59 @@
 #ifndef SYSCALL_DEFS_H
 #define SYSCALL_DEFS_H
 
+// Process scheduling priorities (lower values are scheduled first)
+#define PROC_PRIORITY_HIGH  0
+#define PROC_PRIORITY_LOW   3
+
+// Maximum number of stride scheduling tickets a process may hold
+#define PROC_TICKETS_MAX    1000
+
+// Limits of per-process time slices (in ticks)
+#define PROC_TIMESLICE_MIN  1
+#define PROC_TIMESLICE_MAX  1000
+
+// Real-time (earliest deadline first) scheduling parameters, in ticks
+// (see sys_get_hz() for the tick rate)
+typedef struct rt_params_t {
+    int period;     // Time between job releases (0 to disable)
+    int budget;     // CPU time each job may use
+    int deadline;   // Time after each release the job must finish by
+} rt_params_t;
+
+// Process CPU usage
+typedef struct proc_usage_t {
+    unsigned long long cycles;  // CPU time in time stamp counter cycles
+    unsigned long long usecs;   // CPU time in microseconds
+    int ticks;                  // CPU time in timer ticks
+} proc_usage_t;
+
+// Maximum length of a system call name
+#define SYSCALL_NAME_LEN    24
+
+// System call usage statistics
+typedef struct syscall_stats_t {
+    char name[SYSCALL_NAME_LEN];    // System call name
+    int nargs;                      // Number of arguments
+    unsigned int calls;             // Number of calls made
+    unsigned long long cycles;      // Time spent in the kernel handler
+                                    // (time stamp counter cycles)
+} syscall_stats_t;
+
+// Maximum number of system calls in a batch
+#define SYSCALL_BATCH_MAX   16
+
+// Batched system call flag: stop the batch if the system call fails
+// (returns a negative value)
+#define SYSCALL_BATCH_STOP_ON_ERROR 0x1
+
+// System call made as part of a batch
+typedef struct syscall_batch_t {
+    int syscall;                    // System call number
+    unsigned int args[3];           // System call arguments
+    int flags;                      // SYSCALL_BATCH_* flags
+    int rc;                         // System call return value
+} syscall_batch_t;
+
 // Syscall definitions
 typedef enum {
     SYSCALL_SYS_GET_TIME,
@@ -22,7 +75,33 @@ typedef enum {
     SYSCALL_MUTEX_LOCK,
     SYSCALL_MUTEX_UNLOCK,
     SYSCALL_MSG_SEND,
-    SYSCALL_MSG_RECV
+    SYSCALL_MSG_RECV,
+    SYSCALL_PROC_SET_PRIORITY,
+    SYSCALL_PROC_GET_PRIORITY,
+    SYSCALL_PROC_SET_TICKETS,
+    SYSCALL_PROC_SET_RT,
+    SYSCALL_PROC_SET_TIMESLICE,
+    SYSCALL_PROC_GET_USAGE,
+    SYSCALL_MSLEEP,
+    SYSCALL_USLEEP,
+    SYSCALL_SYS_GET_TIME_MS,
+    SYSCALL_SYS_GET_HZ,
+    SYSCALL_SYS_GET_SYSCALL_STATS,
+    SYSCALL_BATCH,
+    SYSCALL_SYS_READ_KEY,
+    SYSCALL_SYS_WRITE,
+    SYSCALL_MSG_SEND_DONATE,
+    SYSCALL_MSG_SEND_SIZE,
+    SYSCALL_MSG_RECV_SIZE,
+    SYSCALL_MSG_SEND_BUF,
+    SYSCALL_MSG_BUF_ALLOC,
+    SYSCALL_MSG_BUF_MAP,
+    SYSCALL_MSG_BUF_DUP,
+    SYSCALL_MSG_BUF_RELEASE,
+    SYSCALL_MSG_TRY_RECV,
+    SYSCALL_MSG_RECV_TIMEOUT,
+    SYSCALL_MSG_SELECT,
+    SYSCALL_MAX             // Number of system calls (must be last)
 } syscall_t;
 
 #endif
@@ -0,0 +1,176 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2021
+ *
+ * Programmable Interval Timer
+ */
+
+#include <spede/stdio.h>
+#include <spede/machine/io.h>
+
+#include "interrupts.h"
+#include "timer.h"
+
+#define PIT_CH0_DATA    0x40    // Channel 0 data port
+#define PIT_CH2_DATA    0x42    // Channel 2 data port
+#define PIT_CMD         0x43    // Mode/command register
+#define PIT_CH2_GATE    0x61    // Channel 2 gate/output control
+
+#define PIT_CMD_LATCH   0x00    // Channel 0, latch the current count
+#define PIT_CMD_ONESHOT 0x30    // Channel 0, lo/hi byte, mode 0 (terminal count)
+#define PIT_CMD_PERIODIC 0x34   // Channel 0, lo/hi byte, mode 2 (rate generator)
+#define PIT_CMD_CH2     0xb0    // Channel 2, lo/hi byte, mode 0
+
+#define PIT_COUNT_MAX   0xffff  // Largest count the PIT can be programmed with
+
+// Number of PIT clocks in a single tick
+#define PIT_TICK_COUNT  (PIT_FREQ / TIMER_HZ)
+
+#if TIMER_HZ < 100 || TIMER_HZ > 10000
+#error "TIMER_HZ must be between 100 and 10000"
+#endif
+
+// Count loaded for the current one-shot interrupt (0 when periodic)
+static int pit_oneshot_count;
+
+/**
+ * Loads the channel 0 counter with the given mode and count
+ */
+static void timer_load(int cmd, int count) {
+    outportb(PIT_CMD, cmd);
+    outportb(PIT_CH0_DATA, count & 0xff);
+    outportb(PIT_CH0_DATA, (count >> 8) & 0xff);
+}
+
+/**
+ * The PIT is always present
+ */
+static int pit_probe() {
+    return 0;
+}
+
+/**
+ * Programs the PIT to generate periodic interrupts at TIMER_HZ
+ */
+static void pit_set_periodic() {
+    pit_oneshot_count = 0;
+
+    timer_load(PIT_CMD_PERIODIC, PIT_TICK_COUNT);
+
+    if (!irq_enabled(TIMER_INTR)) {
+        irq_enable(TIMER_INTR);
+    }
+}
+
+/**
+ * Programs the PIT to generate a single interrupt after a delay
+ * @param us - delay in microseconds
+ */
+static void pit_set_oneshot(int us) {
+    // The PIT counts 1193 times per millisecond
+    pit_oneshot_count = us * (PIT_FREQ / 1000) / 1000;
+
+    if (pit_oneshot_count > PIT_COUNT_MAX) {
+        pit_oneshot_count = PIT_COUNT_MAX;
+    }
+
+    // Mode 0 starts counting down as soon as the count is loaded and
+    // raises a single interrupt when it reaches zero
+    timer_load(PIT_CMD_ONESHOT, pit_oneshot_count);
+}
+
+/**
+ * Reads the time left before the one-shot interrupt
+ * @return microseconds remaining, -1 if the count already reached zero
+ */
+static int pit_remaining() {
+    int remaining;
+
+    outportb(PIT_CMD, PIT_CMD_LATCH);
+    remaining = inportb(PIT_CH0_DATA);
+    remaining |= inportb(PIT_CH0_DATA) << 8;
+
+    // Once the count reaches zero it wraps around and keeps counting down
+    if (remaining > pit_oneshot_count) {
+        return -1;
+    }
+
+    return remaining * 1000 / (PIT_FREQ / 1000);
+}
+
+/**
+ * Nothing to acknowledge; PIC interrupt lines are dismissed by irq_handler()
+ */
+static void pit_ack() {
+}
+
+// PIT clock event device (always available, shared by all CPUs)
+clockevent_t pit_clockevent = {
+    .name         = "PIT",
+    .vector       = TIMER_INTR,
+    .percpu       = 0,
+    .max_us       = PIT_COUNT_MAX * 1000 / (PIT_FREQ / 1000),
+    .probe        = pit_probe,
+    .set_periodic = pit_set_periodic,
+    .set_oneshot  = pit_set_oneshot,
+    .remaining    = pit_remaining,
+    .ack          = pit_ack
+};
+
+/**
+ * Converts milliseconds to ticks, rounding up so that a delay is never
+ * shorter than requested
+ * @param ms - number of milliseconds
+ * @return number of ticks
+ */
+int timer_ms_to_ticks(int ms) {
+    // Whole seconds are converted separately to avoid overflow
+    return (ms / 1000) * TIMER_HZ + ((ms % 1000) * TIMER_HZ + 999) / 1000;
+}
+
+/**
+ * Converts microseconds to ticks, rounding up so that a delay is never
+ * shorter than requested
+ * @param us - number of microseconds
+ * @return number of ticks
+ */
+int timer_us_to_ticks(int us) {
+    // Whole seconds are converted separately and the remainder is counted
+    // in units of 10 microseconds to avoid overflow
+    return (us / 1000000) * TIMER_HZ +
+           ((us % 1000000 + 9) / 10 * TIMER_HZ + 99999) / 100000;
+}
+
+/**
+ * Converts ticks to milliseconds
+ * @param ticks - number of ticks
+ * @return number of milliseconds
+ */
+int timer_ticks_to_ms(int ticks) {
+    return (ticks / TIMER_HZ) * 1000 + (ticks % TIMER_HZ) * 1000 / TIMER_HZ;
+}
+
+/**
+ * Starts a one-shot reference period on PIT channel 2 for calibrating
+ * other clocks (the tick on channel 0 is left untouched)
+ * @param hz - reference period as a fraction of a second (1/hz seconds)
+ */
+void timer_ref_start(int hz) {
+    int count = PIT_FREQ / hz;
+
+    // Enable the channel 2 gate with the speaker output disabled
+    outportb(PIT_CH2_GATE, (inportb(PIT_CH2_GATE) & ~0x02) | 0x01);
+
+    outportb(PIT_CMD, PIT_CMD_CH2);
+    outportb(PIT_CH2_DATA, count & 0xff);
+    outportb(PIT_CH2_DATA, (count >> 8) & 0xff);
+}
+
+/**
+ * Waits for the reference period started by timer_ref_start() to end
+ */
+void timer_ref_wait() {
+    // The channel 2 output goes high at terminal count
+    while (!(inportb(PIT_CH2_GATE) & 0x20));
+}
@@ -0,0 +1,72 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2021
+ *
+ * Programmable Interval Timer
+ */
+#ifndef TIMER_H
+#define TIMER_H
+
+#include "clockevent.h"
+
+// Timer interrupt frequency (ticks per second)
+// May be overridden at build time (-DTIMER_HZ=...) between 100 and 10000
+#ifndef TIMER_HZ
+#define TIMER_HZ        1000
+#endif
+
+// Converts a constant number of milliseconds to ticks (rounded up)
+#define TIMER_MS(ms)    (((ms) * TIMER_HZ + 999) / 1000)
+
+// Length of a tick in microseconds
+#define TIMER_TICK_US   (1000000 / TIMER_HZ)
+
+// Longest time in seconds whose ticks fit in an int
+#define TIMER_SECS_MAX  (0x7fffffff / TIMER_HZ)
+
+// Stop the periodic tick while the idle task is running (0 to disable)
+#define TIMER_NOHZ      1
+
+// PIT input clock frequency
+#define PIT_FREQ        1193182
+
+// PIT clock event device (always available, shared by all CPUs)
+extern clockevent_t pit_clockevent;
+
+/**
+ * Converts milliseconds to ticks, rounding up so that a delay is never
+ * shorter than requested
+ * @param ms - number of milliseconds
+ * @return number of ticks
+ */
+int timer_ms_to_ticks(int ms);
+
+/**
+ * Converts microseconds to ticks, rounding up so that a delay is never
+ * shorter than requested
+ * @param us - number of microseconds
+ * @return number of ticks
+ */
+int timer_us_to_ticks(int us);
+
+/**
+ * Converts ticks to milliseconds
+ * @param ticks - number of ticks
+ * @return number of milliseconds
+ */
+int timer_ticks_to_ms(int ticks);
+
+/**
+ * Starts a one-shot reference period on PIT channel 2 for calibrating
+ * other clocks (the tick on channel 0 is left untouched)
+ * @param hz - reference period as a fraction of a second (1/hz seconds)
+ */
+void timer_ref_start(int hz);
+
+/**
+ * Waits for the reference period started by timer_ref_start() to end
+ */
+void timer_ref_wait();
+
+#endif
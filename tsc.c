@@ -0,0 +1,69 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2021
+ *
+ * Time Stamp Counter
+ */
+
+#include <spede/stdio.h>
+
+#include "kutil.h"
+#include "timer.h"
+#include "tsc.h"
+
+// Calibration period (1/100th of a second)
+#define TSC_CAL_HZ      100
+
+// Number of time stamp counter cycles per millisecond
+unsigned int tsc_khz;
+
+/**
+ * Measures the time stamp counter frequency against the PIT
+ * PIT channel 2 is used as a one-shot reference so the tick on channel 0
+ * is left untouched
+ */
+void tsc_init() {
+    unsigned long long start;
+    unsigned long long end;
+
+    timer_ref_start(TSC_CAL_HZ);
+    start = tsc_read();
+    timer_ref_wait();
+    end = tsc_read();
+
+    tsc_khz = (unsigned int)(end - start) / (1000 / TSC_CAL_HZ);
+
+    printf("Time stamp counter: %u kHz\n", tsc_khz);
+}
+
+/**
+ * Converts time stamp counter cycles to microseconds
+ * @param cycles - number of cycles
+ * @return number of microseconds (0 if the counter was not calibrated)
+ */
+unsigned long long tsc_to_us(unsigned long long cycles) {
+    if (tsc_khz == 0) {
+        return 0;
+    }
+
+    return mul_div(cycles, 1000, tsc_khz);
+}
+
+/**
+ * Converts time stamp counter cycles to milliseconds
+ * @param cycles - number of cycles
+ * @return number of milliseconds (0 if the counter was not calibrated)
+ */
+unsigned long long tsc_to_ms(unsigned long long cycles) {
+    return mul_div(tsc_to_us(cycles), 1, 1000);
+}
+
+/**
+ * Converts microseconds to time stamp counter cycles
+ * @param us - number of microseconds
+ * @return number of cycles (0 if the counter was not calibrated)
+ */
+unsigned long long tsc_from_us(unsigned long long us) {
+    return mul_div(us, tsc_khz, 1000);
+}
@@ -0,0 +1,46 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2021
+ *
+ * Time Stamp Counter
+ */
+#ifndef TSC_H
+#define TSC_H
+
+// Number of time stamp counter cycles per millisecond
+extern unsigned int tsc_khz;
+
+/**
+ * Reads the time stamp counter of the executing CPU
+ * @return number of cycles since the CPU was reset
+ */
+#define tsc_read() ({ unsigned long long _tsc; asm volatile("rdtsc" : "=A"(_tsc)); _tsc; })
+
+/**
+ * Measures the time stamp counter frequency against the PIT
+ */
+void tsc_init();
+
+/**
+ * Converts time stamp counter cycles to microseconds
+ * @param cycles - number of cycles
+ * @return number of microseconds (0 if the counter was not calibrated)
+ */
+unsigned long long tsc_to_us(unsigned long long cycles);
+
+/**
+ * Converts time stamp counter cycles to milliseconds
+ * @param cycles - number of cycles
+ * @return number of milliseconds (0 if the counter was not calibrated)
+ */
+unsigned long long tsc_to_ms(unsigned long long cycles);
+
+/**
+ * Converts microseconds to time stamp counter cycles
+ * @param us - number of microseconds
+ * @return number of cycles (0 if the counter was not calibrated)
+ */
+unsigned long long tsc_from_us(unsigned long long us);
+
+#endif
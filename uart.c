@@ -0,0 +1,205 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2021
+ *
+ * 16550 UART console driver
+ */
+
+#include <spede/stdio.h>
+#include <spede/machine/io.h>
+
+#include "interrupts.h"
+#include "kproc.h"
+#include "kutil.h"
+#include "uart.h"
+
+// UART registers
+#define UART_THR        (UART_BASE + 0)     // Transmit holding register
+#define UART_DLL        (UART_BASE + 0)     // Divisor latch, low byte
+#define UART_IER        (UART_BASE + 1)     // Interrupt enable register
+#define UART_DLM        (UART_BASE + 1)     // Divisor latch, high byte
+#define UART_FCR        (UART_BASE + 2)     // FIFO control register
+#define UART_IIR        (UART_BASE + 2)     // Interrupt identification register
+#define UART_LCR        (UART_BASE + 3)     // Line control register
+#define UART_MCR        (UART_BASE + 4)     // Modem control register
+#define UART_LSR        (UART_BASE + 5)     // Line status register
+
+#define UART_IER_THRI   0x02    // Interrupt when the transmitter is empty
+#define UART_FCR_ENABLE 0x07    // Enable and clear the FIFOs
+#define UART_LCR_8N1    0x03    // 8 data bits, no parity, 1 stop bit
+#define UART_LCR_DLAB   0x80    // Divisor latch access
+#define UART_MCR_OUT2   0x0b    // DTR, RTS and OUT2 (routes the interrupt)
+#define UART_LSR_THRE   0x20    // Transmit holding register empty
+
+// Base clock of the baud rate generator
+#define UART_CLOCK      115200
+
+// Largest message formatted by uart_printf()
+#define UART_PRINTF_MAX 128
+
+// Characters waiting to be transmitted
+static char uart_tx[UART_TX_SIZE];
+static unsigned int uart_tx_head;   // Next character to add
+static unsigned int uart_tx_tail;   // Next character to transmit
+
+// Transmitter interrupt enabled
+static int uart_tx_busy;
+
+// UART initialized
+static int uart_ready;
+
+// Characters dropped because the transmit buffer was full
+static unsigned int uart_drop_count;
+
+/**
+ * Moves characters from the transmit buffer into the transmit FIFO if it
+ * is empty, and keeps the transmitter interrupt enabled only while there
+ * are characters left to send
+ */
+static void uart_tx_fill() {
+    int i;
+
+    if (inportb(UART_LSR) & UART_LSR_THRE) {
+        for (i = 0; i < UART_FIFO_SIZE && uart_tx_tail != uart_tx_head; i++) {
+            outportb(UART_THR, uart_tx[uart_tx_tail++ & (UART_TX_SIZE - 1)]);
+        }
+    }
+
+    if (uart_tx_tail != uart_tx_head && !uart_tx_busy) {
+        outportb(UART_IER, UART_IER_THRI);
+        uart_tx_busy = 1;
+    } else if (uart_tx_tail == uart_tx_head && uart_tx_busy) {
+        outportb(UART_IER, 0);
+        uart_tx_busy = 0;
+    }
+}
+
+/**
+ * UART interrupt handler
+ */
+static void uart_isr(int irq, void *data) {
+    // Reading the interrupt identification acknowledges the interrupt
+    inportb(UART_IIR);
+
+    uart_tx_fill();
+}
+
+/**
+ * Initializes the UART and enables its interrupt
+ */
+void uart_init() {
+    int divisor = UART_CLOCK / UART_BAUD;
+
+    outportb(UART_IER, 0);
+
+    outportb(UART_LCR, UART_LCR_DLAB);
+    outportb(UART_DLL, divisor & 0xff);
+    outportb(UART_DLM, (divisor >> 8) & 0xff);
+    outportb(UART_LCR, UART_LCR_8N1);
+
+    outportb(UART_FCR, UART_FCR_ENABLE);
+    outportb(UART_MCR, UART_MCR_OUT2);
+
+    uart_tx_busy = 0;
+
+    if (irq_register(IRQ_PIC_BASE + UART_IRQ, uart_isr, NULL) != 0) {
+        panic("Unable to register the UART interrupt handler");
+    }
+
+    irq_enable(UART_IRQ);
+
+    uart_ready = 1;
+
+    // Send anything logged before the UART was ready
+    uart_tx_fill();
+}
+
+/**
+ * Queues characters to be transmitted
+ * @param buf - characters to transmit
+ * @param len - number of characters
+ * @return number of characters queued
+ */
+int uart_write(char *buf, int len) {
+    int i;
+
+    for (i = 0; i < len; i++) {
+        if (uart_tx_head - uart_tx_tail >= UART_TX_SIZE) {
+            uart_drop_count += len - i;
+            break;
+        }
+
+        uart_tx[uart_tx_head++ & (UART_TX_SIZE - 1)] = buf[i];
+    }
+
+    if (uart_ready) {
+        uart_tx_fill();
+    }
+
+    return i;
+}
+
+/**
+ * Formats a message and queues it to be transmitted
+ * @param fmt - printf style format
+ */
+void uart_printf(char *fmt, ...) {
+    char buf[UART_PRINTF_MAX];
+    va_list args;
+    int len;
+
+    va_start(args, fmt);
+    len = vsnprintf(buf, sizeof(buf), fmt, args);
+    va_end(args);
+
+    if (len < 0) {
+        return;
+    }
+
+    if (len >= (int)sizeof(buf)) {
+        len = sizeof(buf) - 1;
+    }
+
+    uart_write(buf, len);
+}
+
+/**
+ * Buffers characters written by a process
+ * @param proc - process entry
+ * @param buf - characters to write
+ * @param len - number of characters
+ * @return number of characters written
+ */
+int uart_proc_write(proc_t *proc, char *buf, int len) {
+    int i;
+
+    for (i = 0; i < len; i++) {
+        proc->write_buf[proc->write_len++] = buf[i];
+
+        if (buf[i] == '\n' || proc->write_len == PROC_WRITE_BUF_SIZE) {
+            uart_proc_flush(proc);
+        }
+    }
+
+    return len;
+}
+
+/**
+ * Queues anything left in a process' write buffer for transmission
+ * @param proc - process entry
+ */
+void uart_proc_flush(proc_t *proc) {
+    if (proc->write_len > 0) {
+        uart_write(proc->write_buf, proc->write_len);
+        proc->write_len = 0;
+    }
+}
+
+/**
+ * Returns the number of characters dropped because the transmit buffer
+ * was full
+ */
+unsigned int uart_dropped() {
+    return uart_drop_count;
+}
@@ -0,0 +1,69 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2021
+ *
+ * 16550 UART console driver
+ */
+#ifndef UART_H
+#define UART_H
+
+#include "kproc.h"
+
+// Serial port used for the console (COM1 by default)
+#ifndef UART_BASE
+#define UART_BASE       0x3f8
+#define UART_IRQ        4
+#endif
+
+#define UART_BAUD       115200  // Baud rate
+#define UART_FIFO_SIZE  16      // Characters the transmit FIFO holds
+#define UART_TX_SIZE    4096    // Characters buffered for transmission
+                                // (must be a power of two)
+
+/**
+ * Initializes the UART and enables its interrupt
+ */
+void uart_init();
+
+/**
+ * Queues characters to be transmitted
+ * Never waits: characters that do not fit in the transmit buffer are
+ * dropped and counted.
+ * @param buf - characters to transmit
+ * @param len - number of characters
+ * @return number of characters queued
+ */
+int uart_write(char *buf, int len);
+
+/**
+ * Formats a message and queues it to be transmitted (see uart_write())
+ * @param fmt - printf style format
+ */
+void uart_printf(char *fmt, ...);
+
+/**
+ * Buffers characters written by a process
+ * Each line is queued for transmission once complete (or once the
+ * process buffer is full) so lines from different processes are not
+ * mixed together.
+ * @param proc - process entry
+ * @param buf - characters to write
+ * @param len - number of characters
+ * @return number of characters written
+ */
+int uart_proc_write(proc_t *proc, char *buf, int len);
+
+/**
+ * Queues anything left in a process' write buffer for transmission
+ * @param proc - process entry
+ */
+void uart_proc_flush(proc_t *proc);
+
+/**
+ * Returns the number of characters dropped because the transmit buffer
+ * was full
+ */
+unsigned int uart_dropped();
+
+#endif
@@ -12,9 +12,13 @@
 // VGA Function prototypes, enumerations, and defintions
 #include "vga.h"
 
-void vga_print_char(int row, int col, int attr, char ch) {
-    unsigned short *vga_ptr = (unsigned short*)VGA_BASE + row * VGA_COL_MAX + col;
+// Screen drawn by the vga_shadow functions
+static unsigned short vga_shadow[VGA_ROW_MAX * VGA_COL_MAX];
 
+/*
+ * Sets a single character cell of a screen buffer
+ */
+static void vga_cell_set(unsigned short *screen, int row, int col, int attr, char ch) {
     // Ensure rows/columns are valid
     if (row < 0 || row >= VGA_ROW_MAX || col < 0 || col >= VGA_COL_MAX) {
         return;
@@ -23,11 +27,14 @@ void vga_print_char(int row, int col, int attr, char ch) {
     // Ensure that only the first byte of the  attribute is considered
     attr &= 0xff;
 
-    // Set the two bytes (attribute + character) in the video memory
-    *vga_ptr = (attr << 8) + ch;
+    // Set the two bytes (attribute + character) in the buffer
+    screen[row * VGA_COL_MAX + col] = (attr << 8) + (unsigned char)ch;
 }
 
-void vga_print_str(int row, int col, int attr, char *str) {
+/*
+ * Writes a string to a screen buffer (see vga_print_str())
+ */
+static void vga_str_set(unsigned short *screen, int row, int col, int attr, char *str) {
     /* Handle a null pointer */
     if (str == NULL) {
         return;
@@ -40,7 +47,7 @@ void vga_print_str(int row, int col, int attr, char *str) {
         } else if (*str == '\t') {
             col = ((col / VGA_TAB_SIZE) + 1) * VGA_TAB_SIZE;
         } else if (*str >= 0x20 && *str != 0x7f) {
-            vga_print_char(row, col, attr, *str);
+            vga_cell_set(screen, row, col, attr, *str);
             col++;
         }
 
@@ -57,6 +64,49 @@ void vga_print_str(int row, int col, int attr, char *str) {
     }
 }
 
+void vga_print_char(int row, int col, int attr, char ch) {
+    vga_cell_set((unsigned short *)VGA_BASE, row, col, attr, ch);
+}
+
+void vga_print_str(int row, int col, int attr, char *str) {
+    vga_str_set((unsigned short *)VGA_BASE, row, col, attr, str);
+}
+
+void vga_shadow_clear(int attr) {
+    int i;
+
+    for (i = 0; i < VGA_ROW_MAX * VGA_COL_MAX; i++) {
+        vga_shadow[i] = ((attr & 0xff) << 8) + ' ';
+    }
+}
+
+void vga_shadow_char(int row, int col, int attr, char ch) {
+    vga_cell_set(vga_shadow, row, col, attr, ch);
+}
+
+void vga_shadow_str(int row, int col, int attr, char *str) {
+    vga_str_set(vga_shadow, row, col, attr, str);
+}
+
+int vga_shadow_flush() {
+    unsigned short *vga_ptr = (unsigned short *)VGA_BASE;
+    int count = 0;
+    int i;
+
+    // Compare with the video memory itself so that anything else printed
+    // to the screen since the last flush is drawn over as well
+    for (i = 0; i < VGA_ROW_MAX * VGA_COL_MAX; i++) {
+        if (vga_ptr[i] == vga_shadow[i]) {
+            continue;
+        }
+
+        vga_ptr[i] = vga_shadow[i];
+        count++;
+    }
+
+    return count;
+}
+
 int vga_attr(int bg_color, int fg_color, int blink) {
     /* Initialize attribute to default: black on back, no bold, no blinking */
     int attr = 0x0;
@@ -64,6 +64,36 @@ void vga_print_char(int row, int col, int attr, char ch);
  */
 void vga_print_str(int row, int col, int attr, char *str);
 
+/*
+ * Clears the shadow screen buffer
+ *
+ * The shadow buffer is drawn with the vga_shadow functions (which work
+ * like the vga_print functions) and then written to the screen with
+ * vga_shadow_flush(), which only updates the characters that changed.
+ *
+ * @param attr - VGA attributes of the cleared screen
+ */
+void vga_shadow_clear(int attr);
+
+/*
+ * Prints a single character into the shadow screen buffer
+ * (see vga_print_char())
+ */
+void vga_shadow_char(int row, int col, int attr, char ch);
+
+/*
+ * Prints a string into the shadow screen buffer (see vga_print_str())
+ */
+void vga_shadow_str(int row, int col, int attr, char *str);
+
+/*
+ * Writes the characters of the shadow screen buffer that differ from the
+ * screen, including any written there by other means since the last flush
+ *
+ * @return number of characters written
+ */
+int vga_shadow_flush();
+
 /*
  * Constructs the byte representation of the VGA attributes
  *
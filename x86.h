@@ -0,0 +1,77 @@
+/**
+ * CPE/CSC 159 - Operating System Pragmatics
+ * California State University, Sacramento
+ * Fall 2021
+ *
+ * Processor identification and model specific registers
+ */
+#ifndef X86_H
+#define X86_H
+
+// CPUID leaf reporting the processor feature flags
+#define CPUID_FEATURES          1
+
+// Processor feature flags (CPUID_FEATURES)
+#define CPUID_EDX_TSC           (1 << 4)    // Time stamp counter
+#define CPUID_EDX_MSR           (1 << 5)    // Model specific registers
+#define CPUID_EDX_APIC          (1 << 9)    // Local APIC
+#define CPUID_EDX_SEP           (1 << 11)   // SYSENTER/SYSEXIT
+#define CPUID_EDX_FXSR          (1 << 24)   // FXSAVE/FXRSTOR
+#define CPUID_EDX_SSE           (1 << 25)   // SSE
+#define CPUID_ECX_TSC_DEADLINE  (1 << 24)   // Local APIC TSC-deadline timer mode
+
+// Model specific registers
+#define MSR_SYSENTER_CS         0x174       // SYSENTER code segment
+#define MSR_SYSENTER_ESP        0x175       // SYSENTER stack pointer
+#define MSR_SYSENTER_EIP        0x176       // SYSENTER entry point
+#define MSR_TSC_DEADLINE        0x6e0       // Local APIC timer TSC deadline
+
+// Control register flags
+#define CR0_MP                  (1 << 1)    // Monitor coprocessor
+#define CR0_EM                  (1 << 2)    // x87 emulation
+#define CR0_TS                  (1 << 3)    // Task switched
+#define CR0_NE                  (1 << 5)    // Native x87 error reporting
+#define CR4_OSFXSR              (1 << 9)    // FXSAVE/FXRSTOR and SSE enabled
+#define CR4_OSXMMEXCPT          (1 << 10)   // Unmasked SSE exceptions supported
+
+/**
+ * Queries processor identification information
+ * @param leaf - information to query
+ * @param a, b, c, d - variables receiving eax, ebx, ecx and edx
+ */
+#define cpuid(leaf, a, b, c, d) \
+    asm volatile("cpuid" : "=a"(a), "=b"(b), "=c"(c), "=d"(d) : "a"(leaf))
+
+/**
+ * Reads a model specific register
+ * @param msr - register number
+ * @return register value
+ */
+#define msr_read(msr) \
+    ({ unsigned long long _msr; asm volatile("rdmsr" : "=A"(_msr) : "c"(msr)); _msr; })
+
+/**
+ * Writes a model specific register
+ * @param msr - register number
+ * @param value - value to write
+ */
+#define msr_write(msr, value) \
+    asm volatile("wrmsr" : : "c"(msr), "A"((unsigned long long)(value)))
+
+/**
+ * Reads a control register
+ * @param cr - register name (cr0, cr4, ...)
+ * @return register value
+ */
+#define cr_read(cr) \
+    ({ unsigned int _cr; asm volatile("movl %%" #cr ", %0" : "=r"(_cr)); _cr; })
+
+/**
+ * Writes a control register
+ * @param cr - register name (cr0, cr4, ...)
+ * @param value - value to write
+ */
+#define cr_write(cr, value) \
+    asm volatile("movl %0, %%" #cr : : "r"((unsigned int)(value)))
+
+#endif